@@ -405,6 +405,24 @@ AC_DEFUN([OVN_VIF_CHECK_UDEV], [
     AM_CONDITIONAL(HAVE_UDEV, test x$HAVE_UDEV=xyes)
 ])
 
+dnl OVN_VIF_ENABLE_RTNETLINK_RENAME_TRACKING
+dnl
+dnl Track netdev renames through rtnetlink instead of libudev
+AC_DEFUN([OVN_VIF_ENABLE_RTNETLINK_RENAME_TRACKING], [
+    AC_ARG_ENABLE(
+      [rtnetlink-rename-tracking],
+      [AC_HELP_STRING([--enable-rtnetlink-rename-tracking],
+                      [Track netdev renames through rtnetlink instead of
+                       libudev])],
+      [], [enable_rtnetlink_rename_tracking=no])
+    AM_CONDITIONAL([ENABLE_RTNETLINK_RENAME_TRACKING],
+                   [test "$enable_rtnetlink_rename_tracking" != no])
+    if test "$enable_rtnetlink_rename_tracking" != no; then
+      AC_DEFINE([ENABLE_RTNETLINK_RENAME_TRACKING], [1],
+                [Track netdev renames through rtnetlink instead of libudev])
+    fi
+])
+
 dnl OVN_VIF_ENABLE_PLUG_REPRESENTOR
 dnl
 dnl Enable the representor plug provider
@@ -5,9 +5,11 @@ lib_libovn_vif_la_LDFLAGS = \
         $(AM_LDFLAGS)
 
 if HAVE_UDEV
+if !ENABLE_RTNETLINK_RENAME_TRACKING
 lib_libovn_vif_la_LDFLAGS += \
 	-ludev
 endif
+endif
 
 lib_libovn_vif_la_SOURCES = \
 	lib/netlink-devlink.h \
@@ -18,11 +18,14 @@
 #include <inttypes.h>
 #include <linux/devlink.h>
 #include <linux/genetlink.h>
+#include <poll.h>
 #include "netlink.h"
 #include "netlink-socket.h"
 #include "netlink-devlink.h"
+#include "openvswitch/poll-loop.h"
 #include "openvswitch/vlog.h"
 #include "packets.h"
+#include "random.h"
 
 VLOG_DEFINE_THIS_MODULE(netlink_devlink);
 
@@ -35,6 +38,23 @@ struct nl_dl_dump_state {
     int error;
 };
 
+struct nl_dl_async_dump {
+    struct nl_sock *sock;       /* Dedicated to this dump. */
+    uint32_t seq;
+    struct ofpbuf buf;          /* Received replies not yet processed. */
+    nl_dl_async_port_cb *port_cb;
+    nl_dl_async_done_cb *done_cb;
+    void *aux;
+    bool done;
+};
+
+struct nl_dl_batch {
+    struct nl_transaction *txns;
+    size_t n_txns;
+    size_t allocated_txns;
+    int error;
+};
+
 static int nl_devlink_init(void);
 
 const char *dl_str_not_present = "";
@@ -150,6 +170,26 @@ nl_dl_info_dump_next(struct nl_dl_dump_state *state,
         (void *) info_entry);
 }
 
+bool
+nl_dl_rate_dump_next(struct nl_dl_dump_state *state,
+                     struct dl_rate *rate_entry)
+{
+    return nl_dl_dump_next__(
+        state,
+        (bool ( * )(struct ofpbuf *, void *)) &nl_dl_parse_rate_policy,
+        (void *) rate_entry);
+}
+
+bool
+nl_dl_param_dump_next(struct nl_dl_dump_state *state,
+                      struct dl_param *param_entry)
+{
+    return nl_dl_dump_next__(
+        state,
+        (bool ( * )(struct ofpbuf *, void *)) &nl_dl_parse_param_policy,
+        (void *) param_entry);
+}
+
 int
 nl_dl_dump_finish(struct nl_dl_dump_state *state)
 {
@@ -157,6 +197,719 @@ nl_dl_dump_finish(struct nl_dl_dump_state *state)
     return nl_dump_done(&state->dump);
 }
 
+/* Returns a new devlink request with command 'cmd' addressed to the device
+ * identified by 'bus_name' and 'dev_name', and to its port with index
+ * 'port_index' unless that is UINT32_MAX. */
+static struct ofpbuf *
+nl_dl_port_request_new(uint8_t cmd, uint32_t flags, const char *bus_name,
+                       const char *dev_name, uint32_t port_index)
+{
+    struct ofpbuf *request;
+
+    request = ofpbuf_new(NLMSG_HDRLEN + GENL_HDRLEN + 128);
+    nl_msg_put_dlgenmsg(request, 0, ovs_devlink_family, cmd, flags);
+    nl_msg_put_string(request, DEVLINK_ATTR_BUS_NAME, bus_name);
+    nl_msg_put_string(request, DEVLINK_ATTR_DEV_NAME, dev_name);
+    if (port_index != UINT32_MAX) {
+        nl_msg_put_u32(request, DEVLINK_ATTR_PORT_INDEX, port_index);
+    }
+    return request;
+}
+
+/* Retrieves the devlink port with index 'port_index' of the device identified
+ * by 'bus_name' and 'dev_name' with a single DEVLINK_CMD_PORT_GET transaction,
+ * which is considerably cheaper than dumping all ports when only one is of
+ * interest.
+ *
+ * On success returns 0, assigns values or pointers to data in 'port_entry'
+ * and stores the reply in '*bufp'.  The caller must not modify 'port_entry',
+ * and must free '*bufp' with ofpbuf_delete() when done with it.  On failure
+ * returns a positive errno value and sets '*bufp' to NULL. */
+int
+nl_dl_port_get(const char *bus_name, const char *dev_name,
+               uint32_t port_index, struct dl_port *port_entry,
+               struct ofpbuf **bufp)
+{
+    struct ofpbuf *request;
+    int error;
+
+    *bufp = NULL;
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_port_request_new(DEVLINK_CMD_PORT_GET, NLM_F_REQUEST,
+                                     bus_name, dev_name, port_index);
+    error = nl_transact(NETLINK_GENERIC, request, bufp);
+    ofpbuf_delete(request);
+    if (error) {
+        return error;
+    }
+
+    if (!nl_dl_parse_port_policy(*bufp, port_entry)) {
+        ofpbuf_delete(*bufp);
+        *bufp = NULL;
+        return EPROTO;
+    }
+    return 0;
+}
+
+/* Creates a new devlink port of flavour 'flavour' on the device identified by
+ * 'bus_name' and 'dev_name', which is the equivalent of 'devlink port add'.
+ * 'pci_pf_number' is the PF the port belongs to and 'pci_sf_number' is the
+ * SF number to assign to the port, which only applies to ports of flavour
+ * DEVLINK_PORT_FLAVOUR_PCI_SF and is ignored if UINT32_MAX.
+ * 'controller_number' is the controller of the PF, which tells a PF of the
+ * host of a SmartNIC from a local one with the same number, and is ignored
+ * if UINT32_MAX.
+ *
+ * The kernel replies with the newly created port, which on success is parsed
+ * into 'port_entry' with the same conventions as nl_dl_port_get.  On failure
+ * returns a positive errno value and sets '*bufp' to NULL. */
+int
+nl_dl_port_new(const char *bus_name, const char *dev_name, uint16_t flavour,
+               uint16_t pci_pf_number, uint32_t pci_sf_number,
+               uint32_t controller_number, struct dl_port *port_entry,
+               struct ofpbuf **bufp)
+{
+    struct ofpbuf *request;
+    int error;
+
+    *bufp = NULL;
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_port_request_new(DEVLINK_CMD_PORT_NEW, NLM_F_REQUEST,
+                                     bus_name, dev_name, UINT32_MAX);
+    nl_msg_put_u16(request, DEVLINK_ATTR_PORT_FLAVOUR, flavour);
+    nl_msg_put_u16(request, DEVLINK_ATTR_PORT_PCI_PF_NUMBER, pci_pf_number);
+    if (flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+        && pci_sf_number != UINT32_MAX) {
+        nl_msg_put_u32(request, DEVLINK_ATTR_PORT_PCI_SF_NUMBER,
+                       pci_sf_number);
+    }
+    if (controller_number != UINT32_MAX) {
+        nl_msg_put_u32(request, DEVLINK_ATTR_PORT_CONTROLLER_NUMBER,
+                       controller_number);
+    }
+    error = nl_transact(NETLINK_GENERIC, request, bufp);
+    ofpbuf_delete(request);
+    if (error) {
+        return error;
+    }
+
+    if (!*bufp || !nl_dl_parse_port_policy(*bufp, port_entry)) {
+        ofpbuf_delete(*bufp);
+        *bufp = NULL;
+        return EPROTO;
+    }
+    return 0;
+}
+
+/* Deletes the devlink port with index 'port_index' of the device identified
+ * by 'bus_name' and 'dev_name', which must have been created with
+ * nl_dl_port_new.  This is the equivalent of 'devlink port del'.
+ *
+ * Returns 0 if successful, otherwise a positive errno value. */
+int
+nl_dl_port_del(const char *bus_name, const char *dev_name, uint32_t port_index)
+{
+    struct ofpbuf *request;
+    int error;
+
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_port_request_new(DEVLINK_CMD_PORT_DEL,
+                                     NLM_F_REQUEST | NLM_F_ACK,
+                                     bus_name, dev_name, port_index);
+    error = nl_transact(NETLINK_GENERIC, request, NULL);
+    ofpbuf_delete(request);
+    return error;
+}
+
+/* Returns a new devlink request with command 'cmd' addressed to the rate
+ * object 'rate', a leaf identified by its port index or a node identified by
+ * its name.  The rates of 'rate' are added unless they are UINT64_MAX, and
+ * the parent node name unless it is NULL, where an empty name detaches the
+ * rate object from its parent. */
+static struct ofpbuf *
+nl_dl_rate_request_new(uint8_t cmd, uint32_t flags,
+                       const struct dl_rate *rate)
+{
+    bool is_leaf = rate->type == DEVLINK_RATE_TYPE_LEAF;
+    struct ofpbuf *request;
+
+    request = nl_dl_port_request_new(cmd, flags, rate->bus_name,
+                                     rate->dev_name,
+                                     is_leaf ? rate->port_index : UINT32_MAX);
+    if (!is_leaf) {
+        nl_msg_put_string(request, DEVLINK_ATTR_RATE_NODE_NAME,
+                          rate->node_name);
+    }
+    if (rate->tx_share != UINT64_MAX) {
+        nl_msg_put_u64(request, DEVLINK_ATTR_RATE_TX_SHARE, rate->tx_share);
+    }
+    if (rate->tx_max != UINT64_MAX) {
+        nl_msg_put_u64(request, DEVLINK_ATTR_RATE_TX_MAX, rate->tx_max);
+    }
+    if (rate->parent_node_name) {
+        nl_msg_put_string(request, DEVLINK_ATTR_RATE_PARENT_NODE_NAME,
+                          rate->parent_node_name);
+    }
+    return request;
+}
+
+/* Retrieves a rate object of the device identified by 'bus_name' and
+ * 'dev_name', the leaf of the port with index 'port_index' if 'node_name' is
+ * NULL, otherwise the node named 'node_name'.
+ *
+ * On success returns 0, assigns values or pointers to data in 'rate_entry'
+ * and stores the reply in '*bufp', see nl_dl_port_get.  On failure returns a
+ * positive errno value and sets '*bufp' to NULL. */
+int
+nl_dl_rate_get(const char *bus_name, const char *dev_name,
+               uint32_t port_index, const char *node_name,
+               struct dl_rate *rate_entry, struct ofpbuf **bufp)
+{
+    struct dl_rate rate = {
+        .bus_name = bus_name,
+        .dev_name = dev_name,
+        .type = node_name ? DEVLINK_RATE_TYPE_NODE : DEVLINK_RATE_TYPE_LEAF,
+        .port_index = port_index,
+        .node_name = node_name,
+        .tx_share = UINT64_MAX,
+        .tx_max = UINT64_MAX,
+    };
+    struct ofpbuf *request;
+    int error;
+
+    *bufp = NULL;
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_rate_request_new(DEVLINK_CMD_RATE_GET, NLM_F_REQUEST,
+                                     &rate);
+    error = nl_transact(NETLINK_GENERIC, request, bufp);
+    ofpbuf_delete(request);
+    if (error) {
+        return error;
+    }
+
+    if (!nl_dl_parse_rate_policy(*bufp, rate_entry)) {
+        ofpbuf_delete(*bufp);
+        *bufp = NULL;
+        return EPROTO;
+    }
+    return 0;
+}
+
+/* Configures the rate object 'rate', which is the equivalent of 'devlink
+ * port function rate set'.  See nl_dl_rate_request_new for which members of
+ * 'rate' are set.
+ *
+ * Returns 0 if successful, otherwise a positive errno value. */
+int
+nl_dl_rate_set(const struct dl_rate *rate)
+{
+    struct ofpbuf *request;
+    int error;
+
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_rate_request_new(DEVLINK_CMD_RATE_SET,
+                                     NLM_F_REQUEST | NLM_F_ACK, rate);
+    error = nl_transact(NETLINK_GENERIC, request, NULL);
+    ofpbuf_delete(request);
+    return error;
+}
+
+/* Creates the rate node 'rate', which must be of type DEVLINK_RATE_TYPE_NODE,
+ * with the rates and parent given in 'rate'.  This is the equivalent of
+ * 'devlink port function rate add'.
+ *
+ * Returns 0 if successful, otherwise a positive errno value. */
+int
+nl_dl_rate_new(const struct dl_rate *rate)
+{
+    struct ofpbuf *request;
+    int error;
+
+    ovs_assert(rate->type == DEVLINK_RATE_TYPE_NODE);
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_rate_request_new(DEVLINK_CMD_RATE_NEW,
+                                     NLM_F_REQUEST | NLM_F_ACK, rate);
+    error = nl_transact(NETLINK_GENERIC, request, NULL);
+    ofpbuf_delete(request);
+    return error;
+}
+
+/* Deletes the rate node named 'node_name' of the device identified by
+ * 'bus_name' and 'dev_name', which is the equivalent of 'devlink port
+ * function rate del'.  The node must not have any children.
+ *
+ * Returns 0 if successful, otherwise a positive errno value. */
+int
+nl_dl_rate_del(const char *bus_name, const char *dev_name,
+               const char *node_name)
+{
+    struct dl_rate rate = {
+        .bus_name = bus_name,
+        .dev_name = dev_name,
+        .type = DEVLINK_RATE_TYPE_NODE,
+        .port_index = UINT32_MAX,
+        .node_name = node_name,
+        .tx_share = UINT64_MAX,
+        .tx_max = UINT64_MAX,
+    };
+    struct ofpbuf *request;
+    int error;
+
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_rate_request_new(DEVLINK_CMD_RATE_DEL,
+                                     NLM_F_REQUEST | NLM_F_ACK, &rate);
+    error = nl_transact(NETLINK_GENERIC, request, NULL);
+    ofpbuf_delete(request);
+    return error;
+}
+
+/* Retrieves the parameter named 'name' of the device identified by
+ * 'bus_name' and 'dev_name', with its value in each configuration mode the
+ * driver supports.
+ *
+ * On success returns 0, assigns values or pointers to data in 'param_entry'
+ * and stores the reply in '*bufp', see nl_dl_port_get.  On failure returns a
+ * positive errno value and sets '*bufp' to NULL. */
+int
+nl_dl_param_get(const char *bus_name, const char *dev_name, const char *name,
+                struct dl_param *param_entry, struct ofpbuf **bufp)
+{
+    struct ofpbuf *request;
+    int error;
+
+    *bufp = NULL;
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_port_request_new(DEVLINK_CMD_PARAM_GET, NLM_F_REQUEST,
+                                      bus_name, dev_name, UINT32_MAX);
+    nl_msg_put_string(request, DEVLINK_ATTR_PARAM_NAME, name);
+    error = nl_transact(NETLINK_GENERIC, request, bufp);
+    ofpbuf_delete(request);
+    if (error) {
+        return error;
+    }
+
+    if (!nl_dl_parse_param_policy(*bufp, param_entry)) {
+        ofpbuf_delete(*bufp);
+        *bufp = NULL;
+        return EPROTO;
+    }
+    return 0;
+}
+
+/* Sets the parameter named 'name' of type 'type' of the device identified by
+ * 'bus_name' and 'dev_name' to 'value' in the configuration mode
+ * 'value->cmode', which is the equivalent of 'devlink dev param set'.  The
+ * type must be the one the driver reports for the parameter.
+ *
+ * Returns 0 if successful, otherwise a positive errno value. */
+int
+nl_dl_param_set(const char *bus_name, const char *dev_name, const char *name,
+                uint8_t type, const struct dl_param_value *value)
+{
+    struct ofpbuf *request;
+    int error;
+
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_port_request_new(DEVLINK_CMD_PARAM_SET,
+                                     NLM_F_REQUEST | NLM_F_ACK,
+                                     bus_name, dev_name, UINT32_MAX);
+    nl_msg_put_string(request, DEVLINK_ATTR_PARAM_NAME, name);
+    nl_msg_put_u8(request, DEVLINK_ATTR_PARAM_TYPE, type);
+    nl_msg_put_u8(request, DEVLINK_ATTR_PARAM_VALUE_CMODE, value->cmode);
+    switch (type) {
+    case DL_PARAM_TYPE_U8:
+        nl_msg_put_u8(request, DEVLINK_ATTR_PARAM_VALUE_DATA, value->data);
+        break;
+    case DL_PARAM_TYPE_U16:
+        nl_msg_put_u16(request, DEVLINK_ATTR_PARAM_VALUE_DATA, value->data);
+        break;
+    case DL_PARAM_TYPE_U32:
+        nl_msg_put_u32(request, DEVLINK_ATTR_PARAM_VALUE_DATA, value->data);
+        break;
+    case DL_PARAM_TYPE_U64:
+        nl_msg_put_u64(request, DEVLINK_ATTR_PARAM_VALUE_DATA, value->data);
+        break;
+    case DL_PARAM_TYPE_STRING:
+        nl_msg_put_string(request, DEVLINK_ATTR_PARAM_VALUE_DATA,
+                          value->string);
+        break;
+    case DL_PARAM_TYPE_BOOL:
+        /* A flag, false is expressed by leaving it out. */
+        if (value->data) {
+            nl_msg_put_flag(request, DEVLINK_ATTR_PARAM_VALUE_DATA);
+        }
+        break;
+    default:
+        ofpbuf_delete(request);
+        return EOPNOTSUPP;
+    }
+    error = nl_transact(NETLINK_GENERIC, request, NULL);
+    ofpbuf_delete(request);
+    return error;
+}
+
+/* Returns a new DEVLINK_CMD_PORT_SET request for the port function of the
+ * port with index 'port_index', setting the attributes of 'port_fn' that are
+ * present according to the conventions of netlink-devlink.h: a hardware
+ * address unless it is all zero, and a state unless it is UINT8_MAX. */
+static struct ofpbuf *
+nl_dl_port_function_request_new(uint32_t flags, const char *bus_name,
+                                const char *dev_name, uint32_t port_index,
+                                const struct dl_port_function *port_fn)
+{
+    struct ofpbuf *request;
+    size_t fn_offset;
+
+    request = nl_dl_port_request_new(DEVLINK_CMD_PORT_SET, flags, bus_name,
+                                     dev_name, port_index);
+    fn_offset = nl_msg_start_nested(request, DEVLINK_ATTR_PORT_FUNCTION);
+    if (!eth_addr_is_zero(port_fn->eth_addr)) {
+        nl_msg_put_unspec(request, DEVLINK_PORT_FUNCTION_ATTR_HW_ADDR,
+                          &port_fn->eth_addr, sizeof port_fn->eth_addr);
+    }
+    if (port_fn->state != UINT8_MAX) {
+        nl_msg_put_u8(request, DEVLINK_PORT_FN_ATTR_STATE, port_fn->state);
+    }
+    nl_msg_end_nested(request, fn_offset);
+    return request;
+}
+
+/* Configures the port function of the devlink port with index 'port_index'
+ * of the device identified by 'bus_name' and 'dev_name', which is the
+ * equivalent of 'devlink port function set'.  See
+ * nl_dl_port_function_request_new for which attributes of 'port_fn' are
+ * set.
+ *
+ * Returns 0 if successful, otherwise a positive errno value. */
+int
+nl_dl_port_function_set(const char *bus_name, const char *dev_name,
+                        uint32_t port_index,
+                        const struct dl_port_function *port_fn)
+{
+    struct ofpbuf *request;
+    int error;
+
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+
+    request = nl_dl_port_function_request_new(NLM_F_REQUEST | NLM_F_ACK,
+                                              bus_name, dev_name, port_index,
+                                              port_fn);
+    error = nl_transact(NETLINK_GENERIC, request, NULL);
+    ofpbuf_delete(request);
+    return error;
+}
+
+/* Allocates and returns a new, empty, batch of devlink requests.  The caller
+ * must free it with nl_dl_batch_destroy when done.
+ *
+ * As with nl_dl_dump_init, one-time initialization of the devlink generic
+ * netlink family is performed here, any error is reported by
+ * nl_dl_batch_run. */
+struct nl_dl_batch *
+nl_dl_batch_create(void)
+{
+    struct nl_dl_batch *batch;
+
+    batch = xzalloc(sizeof *batch);
+    batch->error = nl_devlink_init();
+    return batch;
+}
+
+void
+nl_dl_batch_destroy(struct nl_dl_batch *batch)
+{
+    if (!batch) {
+        return;
+    }
+    for (size_t i = 0; i < batch->n_txns; i++) {
+        ofpbuf_delete(batch->txns[i].request);
+        ofpbuf_delete(batch->txns[i].reply);
+    }
+    free(batch->txns);
+    free(batch);
+}
+
+/* Adds 'request' to 'batch', taking ownership of it. */
+static size_t
+nl_dl_batch_add__(struct nl_dl_batch *batch, struct ofpbuf *request)
+{
+    struct nl_transaction *txn;
+
+    if (batch->n_txns >= batch->allocated_txns) {
+        batch->txns = x2nrealloc(batch->txns, &batch->allocated_txns,
+                                 sizeof *batch->txns);
+    }
+    txn = &batch->txns[batch->n_txns];
+    txn->request = request;
+    txn->reply = ofpbuf_new(1024);
+    txn->error = 0;
+    return batch->n_txns++;
+}
+
+size_t
+nl_dl_batch_add_port_get(struct nl_dl_batch *batch, const char *bus_name,
+                         const char *dev_name, uint32_t port_index)
+{
+    return nl_dl_batch_add__(
+        batch,
+        nl_dl_port_request_new(DEVLINK_CMD_PORT_GET,
+                               NLM_F_REQUEST | NLM_F_ACK,
+                               bus_name, dev_name, port_index));
+}
+
+/* Sends all requests in 'batch' and waits for their outcome.  The requests
+ * are pipelined on a single socket, so that the number of system calls
+ * depends on the size of the requests and replies rather than on the number
+ * of requests.
+ *
+ * Returns 0 if the requests were executed, in which case the outcome of each
+ * of them must be retrieved individually, or a positive errno value if the
+ * devlink family could not be found. */
+int
+nl_dl_batch_run(struct nl_dl_batch *batch)
+{
+    struct nl_transaction **txnsp;
+
+    if (batch->error) {
+        return batch->error;
+    }
+
+    txnsp = xmalloc(batch->n_txns * sizeof *txnsp);
+    for (size_t i = 0; i < batch->n_txns; i++) {
+        txnsp[i] = &batch->txns[i];
+    }
+    nl_transact_multiple(NETLINK_GENERIC, txnsp, batch->n_txns);
+    free(txnsp);
+    return 0;
+}
+
+/* Returns 0 if request 'idx' of 'batch' succeeded, otherwise a positive errno
+ * value. */
+int
+nl_dl_batch_get_error(const struct nl_dl_batch *batch, size_t idx)
+{
+    ovs_assert(idx < batch->n_txns);
+    return batch->txns[idx].error;
+}
+
+/* Parses the reply to the nl_dl_batch_add_port_get request 'idx' of 'batch'
+ * into 'port_entry', which refers to data owned by 'batch'. */
+int
+nl_dl_batch_get_port(const struct nl_dl_batch *batch, size_t idx,
+                     struct dl_port *port_entry)
+{
+    int error = nl_dl_batch_get_error(batch, idx);
+
+    if (error) {
+        return error;
+    }
+    return nl_dl_parse_port_policy(batch->txns[idx].reply, port_entry)
+           ? 0 : EPROTO;
+}
+
+/* Starts an asynchronous dump of devlink ports.  'port_cb' is invoked for
+ * each port and 'done_cb' when the dump is complete, both with 'aux'.
+ *
+ * Returns 0 and stores the dump in '*dumpp' if successful, otherwise a
+ * positive errno value.  The caller must free the dump with
+ * nl_dl_async_dump_destroy. */
+int
+nl_dl_async_port_dump_start(nl_dl_async_port_cb *port_cb,
+                            nl_dl_async_done_cb *done_cb, void *aux,
+                            struct nl_dl_async_dump **dumpp)
+{
+    struct nl_dl_async_dump *dump;
+    struct ofpbuf *request;
+    struct nl_sock *sock;
+    int error;
+
+    *dumpp = NULL;
+    error = nl_devlink_init();
+    if (error) {
+        return error;
+    }
+    error = nl_sock_create(NETLINK_GENERIC, &sock);
+    if (error) {
+        return error;
+    }
+
+    dump = xmalloc(sizeof *dump);
+    dump->sock = sock;
+    dump->seq = random_uint32();
+    ofpbuf_init(&dump->buf, NL_DUMP_BUFSIZE);
+    dump->port_cb = port_cb;
+    dump->done_cb = done_cb;
+    dump->aux = aux;
+    dump->done = false;
+
+    request = ofpbuf_new(NLMSG_HDRLEN + GENL_HDRLEN);
+    nl_msg_put_dlgenmsg(request, 0, ovs_devlink_family, DEVLINK_CMD_PORT_GET,
+                        NLM_F_REQUEST | NLM_F_DUMP | NLM_F_ACK);
+    error = nl_sock_send_seq(sock, request, dump->seq, true);
+    ofpbuf_delete(request);
+    if (error) {
+        nl_dl_async_dump_destroy(dump);
+        return error;
+    }
+
+    *dumpp = dump;
+    return 0;
+}
+
+static void
+nl_dl_async_dump_complete(struct nl_dl_async_dump *dump, int error)
+{
+    dump->done = true;
+    ofpbuf_clear(&dump->buf);
+    if (dump->done_cb) {
+        dump->done_cb(error, dump->aux);
+    }
+}
+
+/* Processes a single message 'msg' received for 'dump'.  Returns true if it
+ * was a reply delivered to the reply callback. */
+static bool
+nl_dl_async_dump_process(struct nl_dl_async_dump *dump, struct ofpbuf *msg)
+{
+    const struct nlmsghdr *nlmsg = msg->data;
+
+    if (nlmsg->nlmsg_seq != dump->seq) {
+        return false;
+    }
+    if (nlmsg->nlmsg_type == NLMSG_DONE) {
+        nl_dl_async_dump_complete(dump, 0);
+        return false;
+    }
+    if (nlmsg->nlmsg_type == NLMSG_ERROR) {
+        const struct nlmsgerr *err;
+
+        err = ofpbuf_at(msg, NLMSG_HDRLEN, sizeof *err);
+        if (!err) {
+            nl_dl_async_dump_complete(dump, EPROTO);
+        } else if (err->error) {
+            nl_dl_async_dump_complete(dump, -err->error);
+        }
+        /* Otherwise it is an acknowledgement, the dump is only complete
+         * once NLMSG_DONE is received. */
+        return false;
+    }
+
+    struct dl_port port_entry;
+
+    if (nl_dl_parse_port_policy(msg, &port_entry)) {
+        if (dump->port_cb) {
+            dump->port_cb(&port_entry, dump->aux);
+        }
+        return true;
+    }
+    nl_dl_async_dump_complete(dump, EPROTO);
+    return false;
+}
+
+/* Processes replies to 'dump' that are available without blocking, invoking
+ * the reply callback for at most 'max_replies' of them, and the completion
+ * callback if the dump completes.  Returns the number of replies delivered,
+ * which is less than 'max_replies' if the dump completed or if no more
+ * replies are ready, in which case nl_dl_async_dump_wait may be used to wait
+ * for them. */
+size_t
+nl_dl_async_dump_run(struct nl_dl_async_dump *dump, size_t max_replies)
+{
+    size_t n = 0;
+
+    while (!dump->done && n < max_replies) {
+        struct ofpbuf msg;
+
+        if (!dump->buf.size) {
+            int error = nl_sock_recv(dump->sock, &dump->buf, NULL, false);
+
+            if (error == EAGAIN) {
+                break;
+            } else if (error) {
+                nl_dl_async_dump_complete(dump, error);
+                break;
+            }
+        }
+        if (!nl_msg_next(&dump->buf, &msg)) {
+            /* Truncated or malformed datagram. */
+            nl_dl_async_dump_complete(dump, EPROTO);
+            break;
+        }
+        if (nl_dl_async_dump_process(dump, &msg)) {
+            n++;
+        }
+    }
+    return n;
+}
+
+/* Causes the poll loop to wake up when more replies to 'dump' are ready. */
+void
+nl_dl_async_dump_wait(const struct nl_dl_async_dump *dump)
+{
+    if (dump->done || dump->buf.size) {
+        poll_immediate_wake();
+    } else {
+        nl_sock_wait(dump->sock, POLLIN);
+    }
+}
+
+bool
+nl_dl_async_dump_is_done(const struct nl_dl_async_dump *dump)
+{
+    return dump->done;
+}
+
+/* Frees 'dump'.  A dump that has not completed is abandoned, without
+ * invoking its completion callback. */
+void
+nl_dl_async_dump_destroy(struct nl_dl_async_dump *dump)
+{
+    if (dump) {
+        nl_sock_destroy(dump->sock);
+        ofpbuf_uninit(&dump->buf);
+        free(dump);
+    }
+}
+
 static uint64_t
 attr_get_up_to_u64(size_t attr_idx, struct nlattr *attrs[],
                    const struct nl_policy policy[],
@@ -480,6 +1233,171 @@ nl_dl_parse_info_policy(struct ofpbuf *msg, struct dl_info *info)
     return true;
 }
 
+bool
+nl_dl_parse_rate_policy(struct ofpbuf *msg, struct dl_rate *rate)
+{
+    static const struct nl_policy policy[] = {
+        [DEVLINK_ATTR_BUS_NAME] = { .type = NL_A_STRING, .optional = false, },
+        [DEVLINK_ATTR_DEV_NAME] = { .type = NL_A_STRING, .optional = false, },
+        [DEVLINK_ATTR_PORT_INDEX] = { .type = NL_A_U32, .optional = true, },
+
+        /* Appeared in Linux v5.14 */
+        [DEVLINK_ATTR_RATE_TYPE] = { .type = NL_A_U16, .optional = false, },
+        [DEVLINK_ATTR_RATE_TX_SHARE] = { .type = NL_A_U64,
+                                         .optional = true, },
+        [DEVLINK_ATTR_RATE_TX_MAX] = { .type = NL_A_U64, .optional = true, },
+        [DEVLINK_ATTR_RATE_NODE_NAME] = { .type = NL_A_STRING,
+                                          .optional = true, },
+        [DEVLINK_ATTR_RATE_PARENT_NODE_NAME] = { .type = NL_A_STRING,
+                                                 .optional = true, },
+    };
+    struct nlattr *attrs[ARRAY_SIZE(policy)];
+
+    if (!nl_policy_parse(msg, NLMSG_HDRLEN + GENL_HDRLEN,
+                         policy, attrs,
+                         ARRAY_SIZE(policy)))
+    {
+        return false;
+    }
+    rate->bus_name = nl_attr_get_string(attrs[DEVLINK_ATTR_BUS_NAME]);
+    rate->dev_name = nl_attr_get_string(attrs[DEVLINK_ATTR_DEV_NAME]);
+    rate->type = nl_attr_get_u16(attrs[DEVLINK_ATTR_RATE_TYPE]);
+    rate->port_index = attr_get_up_to_u64(
+                    DEVLINK_ATTR_PORT_INDEX,
+                    attrs, policy, ARRAY_SIZE(policy));
+    rate->node_name = attr_get_str(
+                    DEVLINK_ATTR_RATE_NODE_NAME,
+                    attrs, policy, ARRAY_SIZE(policy));
+    rate->tx_share = attr_get_up_to_u64(
+                    DEVLINK_ATTR_RATE_TX_SHARE,
+                    attrs, policy, ARRAY_SIZE(policy));
+    rate->tx_max = attr_get_up_to_u64(
+                    DEVLINK_ATTR_RATE_TX_MAX,
+                    attrs, policy, ARRAY_SIZE(policy));
+    rate->parent_node_name = attr_get_str(
+                    DEVLINK_ATTR_RATE_PARENT_NODE_NAME,
+                    attrs, policy, ARRAY_SIZE(policy));
+
+    return true;
+}
+
+/* Parses the DEVLINK_ATTR_PARAM_VALUE 'nla' of a parameter of type 'type'.
+ * The data of a type unknown to us is reported as not present. */
+static bool
+nl_dl_parse_param_value(const struct nlattr *nla, uint8_t type,
+                        struct dl_param_value *value)
+{
+    static const struct nl_policy policy[] = {
+        [DEVLINK_ATTR_PARAM_VALUE_DATA] = { .type = NL_A_UNSPEC,
+                                            .optional = true, },
+        [DEVLINK_ATTR_PARAM_VALUE_CMODE] = { .type = NL_A_U8,
+                                             .optional = false, },
+    };
+    struct nlattr *attrs[ARRAY_SIZE(policy)];
+    const struct nlattr *data;
+
+    if (!nl_parse_nested(nla, policy, attrs, ARRAY_SIZE(policy))) {
+        return false;
+    }
+    value->cmode = nl_attr_get_u8(attrs[DEVLINK_ATTR_PARAM_VALUE_CMODE]);
+    value->data = UINT64_MAX;
+    value->string = dl_str_not_present;
+
+    data = attrs[DEVLINK_ATTR_PARAM_VALUE_DATA];
+    switch (type) {
+    case DL_PARAM_TYPE_U8:
+        if (!data || nl_attr_get_size(data) != sizeof(uint8_t)) {
+            return false;
+        }
+        value->data = nl_attr_get_u8(data);
+        break;
+    case DL_PARAM_TYPE_U16:
+        if (!data || nl_attr_get_size(data) != sizeof(uint16_t)) {
+            return false;
+        }
+        value->data = nl_attr_get_u16(data);
+        break;
+    case DL_PARAM_TYPE_U32:
+        if (!data || nl_attr_get_size(data) != sizeof(uint32_t)) {
+            return false;
+        }
+        value->data = nl_attr_get_u32(data);
+        break;
+    case DL_PARAM_TYPE_U64:
+        if (!data || nl_attr_get_size(data) != sizeof(uint64_t)) {
+            return false;
+        }
+        value->data = nl_attr_get_u64(data);
+        break;
+    case DL_PARAM_TYPE_STRING:
+        if (!data || !memchr(nl_attr_get(data), '\0',
+                             nl_attr_get_size(data))) {
+            return false;
+        }
+        value->string = nl_attr_get_string(data);
+        break;
+    case DL_PARAM_TYPE_BOOL:
+        value->data = data != NULL;
+        break;
+    }
+    return true;
+}
+
+bool
+nl_dl_parse_param_policy(struct ofpbuf *msg, struct dl_param *param)
+{
+    static const struct nl_policy policy[] = {
+        [DEVLINK_ATTR_BUS_NAME] = { .type = NL_A_STRING, .optional = false, },
+        [DEVLINK_ATTR_DEV_NAME] = { .type = NL_A_STRING, .optional = false, },
+
+        /* Appeared in Linux v4.19 */
+        [DEVLINK_ATTR_PARAM] = { .type = NL_A_NESTED, .optional = false, },
+    };
+    static const struct nl_policy param_policy[] = {
+        [DEVLINK_ATTR_PARAM_NAME] = { .type = NL_A_STRING,
+                                      .optional = false, },
+        [DEVLINK_ATTR_PARAM_GENERIC] = { .type = NL_A_FLAG,
+                                         .optional = true, },
+        [DEVLINK_ATTR_PARAM_TYPE] = { .type = NL_A_U8, .optional = false, },
+        [DEVLINK_ATTR_PARAM_VALUES_LIST] = { .type = NL_A_NESTED,
+                                             .optional = false, },
+    };
+    struct nlattr *param_attrs[ARRAY_SIZE(param_policy)];
+    struct nlattr *attrs[ARRAY_SIZE(policy)];
+    const struct nlattr *nla;
+    size_t left;
+
+    if (!nl_policy_parse(msg, NLMSG_HDRLEN + GENL_HDRLEN,
+                         policy, attrs,
+                         ARRAY_SIZE(policy))
+        || !nl_parse_nested(attrs[DEVLINK_ATTR_PARAM], param_policy,
+                            param_attrs, ARRAY_SIZE(param_policy)))
+    {
+        return false;
+    }
+    param->bus_name = nl_attr_get_string(attrs[DEVLINK_ATTR_BUS_NAME]);
+    param->dev_name = nl_attr_get_string(attrs[DEVLINK_ATTR_DEV_NAME]);
+    param->name = nl_attr_get_string(param_attrs[DEVLINK_ATTR_PARAM_NAME]);
+    param->generic = param_attrs[DEVLINK_ATTR_PARAM_GENERIC] != NULL;
+    param->type = nl_attr_get_u8(param_attrs[DEVLINK_ATTR_PARAM_TYPE]);
+
+    param->n_values = 0;
+    NL_NESTED_FOR_EACH (nla, left,
+                        param_attrs[DEVLINK_ATTR_PARAM_VALUES_LIST]) {
+        if (nl_attr_type(nla) != DEVLINK_ATTR_PARAM_VALUE) {
+            continue;
+        }
+        if (param->n_values >= ARRAY_SIZE(param->values)
+            || !nl_dl_parse_param_value(nla, param->type,
+                                        &param->values[param->n_values])) {
+            return false;
+        }
+        param->n_values++;
+    }
+
+    return true;
+}
+
 static int
 nl_devlink_init(void)
 {
@@ -69,6 +69,51 @@ struct dl_port {
     uint32_t pci_sf_number;
 };
 
+/* A devlink rate object, either a leaf belonging to a port or a node that
+ * groups other rate objects.  Rates are in bytes per second, where 0 means
+ * no limit. */
+struct dl_rate {
+    const char *bus_name;
+    const char *dev_name;
+    uint16_t type;                /* DEVLINK_RATE_TYPE_* */
+    uint32_t port_index;          /* type DEVLINK_RATE_TYPE_LEAF */
+    const char *node_name;        /* type DEVLINK_RATE_TYPE_NODE */
+    uint64_t tx_share;
+    uint64_t tx_max;
+    const char *parent_node_name;
+};
+
+/* Types of devlink parameter values, as carried in DEVLINK_ATTR_PARAM_TYPE.
+ * The kernel uses its internal netlink attribute types here, which the
+ * devlink uapi header does not define. */
+enum dl_param_type {
+    DL_PARAM_TYPE_U8 = 1,
+    DL_PARAM_TYPE_U16 = 2,
+    DL_PARAM_TYPE_U32 = 3,
+    DL_PARAM_TYPE_U64 = 4,
+    DL_PARAM_TYPE_STRING = 5,
+    DL_PARAM_TYPE_BOOL = 6,
+};
+
+/* The value of a devlink parameter in one configuration mode. */
+struct dl_param_value {
+    uint8_t cmode;                /* DEVLINK_PARAM_CMODE_* */
+    uint64_t data;                /* Integer types, 0 or 1 for BOOL. */
+    const char *string;           /* type DL_PARAM_TYPE_STRING */
+};
+
+/* A devlink device parameter along with its value in each of the
+ * configuration modes it supports. */
+struct dl_param {
+    const char *bus_name;
+    const char *dev_name;
+    const char *name;
+    bool generic;
+    uint8_t type;                 /* DL_PARAM_TYPE_* */
+    size_t n_values;
+    struct dl_param_value values[DEVLINK_PARAM_CMODE_MAX + 1];
+};
+
 struct dl_info_version {
     const char *name;
     const char *value;
@@ -106,10 +151,74 @@ void nl_msg_put_dlgenmsg(struct ofpbuf *, size_t, int, uint8_t, uint32_t);
 void nl_dl_dump_start(uint8_t, struct nl_dl_dump_state *);
 bool nl_dl_port_dump_next(struct nl_dl_dump_state *, struct dl_port *);
 bool nl_dl_info_dump_next(struct nl_dl_dump_state *, struct dl_info *);
+bool nl_dl_rate_dump_next(struct nl_dl_dump_state *, struct dl_rate *);
+bool nl_dl_param_dump_next(struct nl_dl_dump_state *, struct dl_param *);
 int nl_dl_dump_finish(struct nl_dl_dump_state *);
+int nl_dl_port_get(const char *, const char *, uint32_t, struct dl_port *,
+                   struct ofpbuf **);
+int nl_dl_port_function_set(const char *, const char *, uint32_t,
+                            const struct dl_port_function *);
+int nl_dl_port_new(const char *, const char *, uint16_t, uint16_t, uint32_t,
+                   uint32_t, struct dl_port *, struct ofpbuf **);
+int nl_dl_port_del(const char *, const char *, uint32_t);
+int nl_dl_rate_get(const char *, const char *, uint32_t, const char *,
+                   struct dl_rate *, struct ofpbuf **);
+int nl_dl_rate_set(const struct dl_rate *);
+int nl_dl_rate_new(const struct dl_rate *);
+int nl_dl_rate_del(const char *, const char *, const char *);
+int nl_dl_param_get(const char *, const char *, const char *,
+                    struct dl_param *, struct ofpbuf **);
+int nl_dl_param_set(const char *, const char *, const char *, uint8_t,
+                    const struct dl_param_value *);
+
+/* A batch of devlink requests, sent and answered with as few system calls as
+ * possible.  Requests are added with nl_dl_batch_add_port_get, which
+ * returns the position of the request in the batch, all of them are then
+ * executed by nl_dl_batch_run, after which the outcome of each request is
+ * retrieved by its position.
+ *
+ * The declaration of nl_dl_batch is kept private for the same reason as that
+ * of nl_dl_dump_state. */
+struct nl_dl_batch;
+
+struct nl_dl_batch *nl_dl_batch_create(void);
+void nl_dl_batch_destroy(struct nl_dl_batch *);
+size_t nl_dl_batch_add_port_get(struct nl_dl_batch *, const char *,
+                                const char *, uint32_t);
+int nl_dl_batch_run(struct nl_dl_batch *);
+int nl_dl_batch_get_error(const struct nl_dl_batch *, size_t);
+int nl_dl_batch_get_port(const struct nl_dl_batch *, size_t,
+                         struct dl_port *);
+
+/* Asynchronous dumps of devlink ports.
+ *
+ * Unlike the nl_dl_dump_* functions, which block until the kernel replies,
+ * an asynchronous dump never blocks, which allows it to be driven from a
+ * poll loop: call nl_dl_async_dump_run from the run phase to process the
+ * replies that are ready, and nl_dl_async_dump_wait from the wait phase to
+ * be woken up when more are.  The reply callback is invoked for each reply,
+ * with an entry that refers to data only valid for the duration of the call,
+ * and the completion callback is invoked once, with 0 or a positive errno
+ * value, when the dump is complete.
+ *
+ * The declaration of nl_dl_async_dump is kept private for the same reason as
+ * that of nl_dl_dump_state. */
+struct nl_dl_async_dump;
+
+typedef void nl_dl_async_port_cb(struct dl_port *, void *aux);
+typedef void nl_dl_async_done_cb(int error, void *aux);
+
+int nl_dl_async_port_dump_start(nl_dl_async_port_cb *, nl_dl_async_done_cb *,
+                                void *aux, struct nl_dl_async_dump **);
+size_t nl_dl_async_dump_run(struct nl_dl_async_dump *, size_t);
+void nl_dl_async_dump_wait(const struct nl_dl_async_dump *);
+bool nl_dl_async_dump_is_done(const struct nl_dl_async_dump *);
+void nl_dl_async_dump_destroy(struct nl_dl_async_dump *);
 bool nl_dl_parse_port_policy(struct ofpbuf *, struct dl_port *);
 bool nl_dl_parse_port_function(struct nlattr *, struct dl_port_function *);
 bool nl_dl_parse_info_policy(struct ofpbuf *, struct dl_info *);
+bool nl_dl_parse_rate_policy(struct ofpbuf *, struct dl_rate *);
+bool nl_dl_parse_param_policy(struct ofpbuf *, struct dl_param *);
 bool nl_dl_parse_info_version(struct nlattr *, struct dl_info_version *);
 
 #endif /* NETLINK_DEVLINK_H */
@@ -14,62 +14,223 @@
  */
 
 #include <config.h>
+#include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <linux/devlink.h>
+#include <linux/filter.h>
 #include <net/if.h>
-
-#ifdef HAVE_UDEV
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Netdev renames, for example as a result of systemd predictable network
+ * interface naming, are tracked through libudev when available.  Configuring
+ * with --enable-rtnetlink-rename-tracking replaces libudev with a lightweight
+ * tracker built on a rtnetlink socket. */
+#if defined(ENABLE_RTNETLINK_RENAME_TRACKING)
+#define RENAME_TRACKING_RTNL 1
+#elif defined(HAVE_UDEV)
+#define RENAME_TRACKING_UDEV 1
+#endif
+
+#if defined(RENAME_TRACKING_UDEV) || defined(RENAME_TRACKING_RTNL)
+#define RENAME_TRACKING 1
+#endif
+
+#ifdef RENAME_TRACKING_UDEV
 #include <libudev.h>
-#endif /* HAVE_UDEV */
+#endif /* RENAME_TRACKING_UDEV */
 
 #include "vif-plug-provider.h"
 
+#include "cmap.h"
+#include "dirs.h"
 #include "hash.h"
+#include "latch.h"
+#include "openvswitch/dynamic-string.h"
 #include "openvswitch/hmap.h"
+#include "openvswitch/list.h"
 #include "openvswitch/vlog.h"
 #include "netlink.h"
+#include "netlink-notifier.h"
 #include "netlink-socket.h"
 #include "netlink-devlink.h"
+#include "openvswitch/poll-loop.h"
+#include "ovs-rcu.h"
+#include "ovs-thread.h"
 #include "packets.h"
 #include "random.h"
+#include "rtnetlink.h"
+#include "seq.h"
 #include "openvswitch/shash.h"
+#include "smap.h"
+#include "sset.h"
+#include "timeval.h"
+#include "unixctl.h"
+#include "vswitch-idl.h"
 
 VLOG_DEFINE_THIS_MODULE(vif_plug_representor);
 
 enum port_node_source {
     PORT_NODE_SOURCE_DUMP,
     PORT_NODE_SOURCE_RUNTIME,
+    PORT_NODE_SOURCE_SNAPSHOT, /* Restored from snapshot, not yet confirmed by
+                                * a devlink dump. */
+};
+
+/* The members of a port node that change when the port is renamed or
+ * re-keyed, as seen by lock-free readers.  A snapshot is never modified once
+ * published, the writer publishes a new one instead, see port_node_publish.
+ * The other members used by lookups, 'number' and 'flavour' of a port node,
+ * 'bus_name' and 'dev_name' of a phy_node, and 'pf' and 'bdf' of a
+ * function_node, do not change once the node is in the table. */
+struct port_keys {
+    uint32_t netdev_ifindex;
+    struct eth_addr mac;
+    struct eth_addr pf_mac;     /* MAC of the PF of a function. */
+    char netdev_name[];
 };
 
+/* A representor port.
+ *
+ * Ports are stored in one of two record types depending on their flavour,
+ * struct phy_node for PHYSICAL and PCI_PF ports, and struct function_node
+ * for PCI_VF and PCI_SF ports, both embedding this common part.  There may
+ * be tens of thousands of functions per device, so the records are kept
+ * compact, and the members used by lookups are placed first so that a lookup
+ * touches as few cache lines as possible. */
 struct port_node {
-    struct hmap_node mac_vf_node;
-    struct hmap_node ifindex_node;
-    struct hmap_node bus_dev_node;
+    /* Hot: used by lookups. */
+    struct cmap_node ifindex_node;
+    OVSRCU_TYPE(struct port_keys *) keys;
     uint32_t netdev_ifindex;
-    char *netdev_name;
-    bool netdev_renamed;
     /* Which attribute is stored here depends on the value of 'flavour'.
      *
      * Flavour:                       Devlink attrbiute:
      * DEVLINK_PORT_FLAVOUR_PHYSICAL  DEVLINK_ATTR_PORT_NUMBER
      * DEVLINK_PORT_FLAVOUR_PCI_PF    DEVLINK_ATTR_PORT_PCI_PF_NUMBER
-     * DEVLINK_PORT_FLAVOUR_PCI_VF    DEVLINK_ATTR_PORT_PCI_VF_NUMBER */
+     * DEVLINK_PORT_FLAVOUR_PCI_VF    DEVLINK_ATTR_PORT_PCI_VF_NUMBER
+     * DEVLINK_PORT_FLAVOUR_PCI_SF    DEVLINK_ATTR_PORT_PCI_SF_NUMBER */
     uint32_t number;
     uint16_t flavour;
     struct eth_addr mac;
-    struct port_node *pf;
-    enum port_node_source port_node_source;
+    uint8_t port_node_source; /* One of enum port_node_source. */
+    bool netdev_renamed;
+    /* 'netdev_ifindex', 'mac' and 'netdev_name' are the writer's copy of
+     * 'keys', only accessed with 'port_table_mutex' held, see struct
+     * port_table. */
+    char *netdev_name;
+
+    /* Cold: bookkeeping. */
+
+    /* In 'rename_wait_list' while we wait for the netdev of a port created
+     * at runtime to be renamed, see port_node_rename_expected. */
+    struct ovs_list rename_wait_node;
+    long long int rename_wait_start;
+    /* Devlink port index, allows refreshing the port with a targeted request,
+     * UINT32_MAX if not known yet. */
+    uint32_t dl_port_index;
+    /* Not reported yet by the resynchronization dump in progress, if any. */
+    bool resync_stale;
+};
+
+/* A PHYSICAL or PCI_PF port. */
+struct phy_node {
+    struct cmap_node bus_dev_node;
+    struct port_node up;
+    /* Devlink bus and device name, a function inherits them from its PF. */
+    char *bus_name;
+    char *dev_name;
+    /* For PF ports, the list of its functions.  Allows re-indexing the
+     * functions of a PF when its MAC changes. */
+    struct ovs_list children;
+    /* Cache of the host PF MAC address retrieved through the sysfs
+     * compatibility interface relative to this ports netdev name.  Only used
+     * for PHYSICAL ports, see phy_node_get_host_pf_mac. */
+    struct eth_addr compat_pf_mac;
+    bool compat_pf_mac_valid;
+    long long int compat_pf_mac_next; /* When to read the file again. */
+    /* For local PF ports, the PCI address of the first VF and the distance
+     * between VFs, derived from the SR-IOV capability of the PF.  See
+     * port_table_probe_pf_sriov. */
+    uint32_t vf_bdf_base;      /* PCI_BDF_NONE if unknown. */
+    uint16_t vf_bdf_stride;
+    bool sriov_probed;
+    /* For PF ports, the controller the PF belongs to, UINT32_MAX if not
+     * known, and whether it is external, i.e. a PF of the host of a SmartNIC
+     * DPU.  SFs are created on the controller of their PF. */
+    uint32_t controller;
+    bool external;
+    /* For PF ports, the next SF number to try for the warm pool, see
+     * port_table_sf_pool_run. */
+    uint32_t sf_pool_next_num;
+    /* For PF ports, the SFs to be created, see struct sf_request. */
+    struct ovs_list sf_requests;
+};
+
+/* PCI addresses are stored as domain << 16 | bus << 8 | device << 3 |
+ * function, which makes the address of a VF a simple offset from its PF. */
+#define PCI_BDF_NONE UINT32_MAX
+
+/* Devlink rate last applied to the rate leaf of a function. */
+struct port_rate {
+    uint64_t tx_share;          /* Bytes per second, 0 if unlimited. */
+    uint64_t tx_max;            /* Bytes per second, 0 if unlimited. */
+    char *parent;               /* Rate group, empty if none. */
+};
+
+/* A PCI_VF or PCI_SF port. */
+struct function_node {
+    struct cmap_node mac_vf_node; /* Hashed by port_table_hash_function(). */
+    uint32_t mac_vf_hash; /* Hash 'mac_vf_node' was inserted with, the PF MAC
+                           * may change while the node is in the table. */
+    struct cmap_node function_mac_node; /* Hashed on 'up.mac'. */
+    struct phy_node *pf;
+    struct cmap_node bdf_node;  /* Only in table if 'bdf' is known. */
+    uint32_t bdf;               /* Host PCI address, or PCI_BDF_NONE. */
+    struct port_node up;
+    struct ovs_list pf_node; /* In 'pf->children'. */
+    struct port_rate *rate;  /* NULL until the rate leaf has been queried. */
+    bool provisioned;        /* SF created by us, deleted on unplug. */
 };
 
+static bool
+port_node_is_phy(const struct port_node *pn)
+{
+    return pn->flavour == DEVLINK_PORT_FLAVOUR_PHYSICAL
+           || pn->flavour == DEVLINK_PORT_FLAVOUR_PCI_PF;
+}
+
+static struct phy_node *
+phy_node_cast(const struct port_node *pn)
+{
+    ovs_assert(port_node_is_phy(pn));
+    return CONTAINER_OF(pn, struct phy_node, up);
+}
+
+static struct function_node *
+function_node_cast(const struct port_node *pn)
+{
+    ovs_assert(!port_node_is_phy(pn));
+    return CONTAINER_OF(pn, struct function_node, up);
+}
+
 /* Port table.
  *
  * This data structure contains three indexes:
  *
- * mac_vf_table   - port_node by PF MAC and VF number.
+ * mac_vf_table   - port_node by PF MAC and VF or SF number.
  * ifindex_table  - port_node by netdev ifindex.
  * bus_dev_table  - port_node by bus/dev name (only contains PHYSICAL and
  *                  PCI_PF ports).
+ * function_mac_table - port_node by function MAC (only contains PCI_VF and
+ *                      PCI_SF ports with a non-zero MAC).
+ * bdf_table      - port_node by host PCI address (only contains PCI_VF ports
+ *                  of PFs with a known SR-IOV layout).
  *
  * There is a small number of PHYSICAL and PF flavoured ports per device.  We
  * will need to refer to these for every update we get to a VF in order to
@@ -81,71 +242,640 @@ struct port_node {
  * through devlink on the PF representor there is a compatibility interface in
  * sysfs which is relative to a PHYSICAL ports netdev name (see the
  * compat_get_host_pf_mac function).
+ *
+ * Thread-safety
+ * =============
+ *
+ * The table may be modified by the main thread and by the monitor thread,
+ * always with 'port_table_mutex' held.
+ *
+ * Lookups do not need the mutex.  The indexes are cmaps, removed port nodes
+ * are freed after an RCU grace period, and lookups only compare members that
+ * do not change while a node is in the table or that are part of the
+ * node's RCU protected struct port_keys.  A thread that does not hold the
+ * mutex may use a node it looked up until its next quiescent period, but
+ * must only read the keys through port_node_keys, never the writer's copies
+ * in the node itself.  Everything else, including the rename wait list, the
+ * SF requests and the rates, requires the mutex.
  */
 struct port_table {
-    struct hmap mac_vf_table; /* Hash table for lookups by mac+vf_num */
+    struct cmap mac_vf_table; /* Hash table for lookups by mac+vf_num */
     uint32_t mac_seed; /* We reuse the OVS mac+vlan hash functions for the
                         * PF MAC+VF number, and they require a uint32_t seed */
-    struct hmap ifindex_table; /* Hash table for lookups by ifindex */
-    struct hmap bus_dev_table; /* Hash table for lookup of PHYSICAL and PF
+    struct cmap ifindex_table; /* Hash table for lookups by ifindex */
+    struct cmap bus_dev_table; /* Hash table for lookup of PHYSICAL and PF
                                 * ports by their bus_name/dev_name string.
                                 * While there is a large number of VFs or SFs
                                 * they will be associated with a small number
                                 * of PFs */
+    struct cmap function_mac_table; /* Hash table for lookups by the MAC of
+                                     * a function, as seen by its host. */
+    struct cmap bdf_table; /* Hash table for lookups by host PCI address */
+    struct hmap pending_table; /* Functions reported before their PF, see
+                                * struct pending_pf. */
 };
 
+/* Functions waiting for their PF.
+ *
+ * Depending on the order of dump replies and notifications, and in
+ * particular while a device recovers from a firmware reset, we may learn
+ * about a VF before its PF.  As the VF index is keyed on the PF MAC the
+ * function can not be inserted yet, so we park it in a list per
+ * (device, pf-number) and insert all of them in one go when the PF arrives.
+ * Functions whose PF does not arrive within PENDING_TIMEOUT_MSEC are
+ * dropped, the devlink device they belong to is most likely gone.
+ */
+struct pending_pf {
+    struct hmap_node hmap_node; /* In port_table's 'pending_table'. */
+    char *bus_name;
+    char *dev_name;
+    uint16_t pci_pf_number;
+    struct ovs_list functions;  /* Contains struct pending_function. */
+};
+
+struct pending_function {
+    struct ovs_list list_node;  /* In pending_pf's 'functions'. */
+    uint32_t netdev_ifindex;
+    char *netdev_name;
+    uint32_t number;            /* VF or SF number depending on 'flavour'. */
+    uint16_t flavour;
+    struct eth_addr mac;
+    enum port_node_source port_node_source;
+    bool detached;              /* In the table before its PF went away. */
+    long long int parked;       /* Time of the first report. */
+};
+
+#define PENDING_TIMEOUT_MSEC (5 * 60 * 1000)
+
 static struct port_table *port_table;
+static struct ovs_mutex port_table_mutex = OVS_MUTEX_INITIALIZER;
 
-static struct port_node *
-port_node_create(uint32_t netdev_ifindex, const char *netdev_name,
-                 uint32_t number, uint16_t flavour,
-                 struct eth_addr mac, struct port_node *pf,
-                 enum port_node_source port_node_source)
+/* Interface options maintained by this provider.
+ *
+ * ovn-controller uses this set to know which keys in the OVS Interface
+ * options column it may remove or update on behalf of the provider.  The
+ * values are derived from the port table, which means they are stable for as
+ * long as the representor itself does not change. */
+#define OPT_PF_MAC "vif-plug:representor:pf-mac"
+#define OPT_VF_NUM "vif-plug:representor:vf-num"
+#define OPT_SF_NUM "vif-plug:representor:sf-num"
+#define OPT_IFINDEX "vif-plug:representor:ifindex"
+#define OPT_SF_PROVISIONED "vif-plug:representor:sf-provisioned"
+
+/* Keys in the other_config column of the Open_vSwitch table. */
+#define CFG_MONITOR_THREAD "vif-plug:representor:monitor-thread"
+#define CFG_RUN_BUDGET_MSEC "vif-plug:representor:run-budget-msec"
+#define CFG_SF_PROVISIONING "vif-plug:representor:sf-provisioning"
+
+/* On-demand SF provisioning.
+ *
+ * When enabled through the CFG_SF_PROVISIONING key, an lport asking for an
+ * SF that does not exist makes us create it rather than wait for external
+ * orchestration to do so: the SF port is added with DEVLINK_CMD_PORT_NEW,
+ * its host facing MAC is programmed, it is activated, and the lport is
+ * plugged once its representor has settled on its final netdev name.  The
+ * creation is requested by port_prepare and carried out from the main loop.
+ * Removing the lport deletes the SF again. */
+static bool sf_provisioning;
+
+#define CFG_SF_POOL_SIZE "vif-plug:representor:sf-pool-size"
+
+/* Warm pool of SFs.
+ *
+ * Creating and activating an SF and having the host probe its auxiliary
+ * device takes hundreds of milliseconds, which is too long to sit on the
+ * plug path.  With SF provisioning enabled and CFG_SF_POOL_SIZE set, we keep
+ * that many idle SFs created and activated ahead of time on each PF.  An
+ * lport asking for a pooled SF claims an idle one by programming its host
+ * facing MAC, after which it is an ordinary provisioned SF that is deleted
+ * when the lport is unplugged, and the pool is refilled in the background.
+ *
+ * Pooled SFs are numbered from SF_POOL_NUM_BASE to stay out of the way of SF
+ * numbers chosen by the CMS, and remain idle for as long as their function
+ * MAC is unset.  Both are properties of the kernel objects, so the pool
+ * survives a restart of ovn-controller. */
+#define SF_POOL_NUM_BASE 0x10000
+#define SF_POOL_RUN_INTERVAL_MSEC 1000
+static unsigned int sf_pool_size;
+static long long int sf_pool_next_run;
+
+/* An SF to be created on a PF, for an lport or for the warm pool.
+ *
+ * Creating and activating an SF takes two devlink transactions, which block
+ * for as long as the driver needs.  Requests are therefore only queued
+ * under 'port_table_mutex', and carried out from the main loop without
+ * holding it, see port_table_sf_requests_run.  Once the SF is created the
+ * request is kept until its representor is reported, so that the pool does
+ * not create another SF in its place in the meantime. */
+struct sf_request {
+    struct ovs_list list_node;  /* In 'sf_requests' of the PF. */
+    uint32_t sf_num;
+    struct eth_addr mac;        /* Host facing MAC, all zeros for the pool. */
+    long long int started;      /* LLONG_MIN until being carried out. */
+};
+
+/* Time after which a request whose representor was not reported is given
+ * up on. */
+#define SF_REQUEST_TIMEOUT_MSEC 30000
+
+#define CFG_DEVLINK_PARAMS "vif-plug:representor:devlink-params"
+
+/* Devlink parameter profile.
+ *
+ * Driver parameters such as the flow steering mode of mlx5, which changes
+ * the rate at which flows can be offloaded by an order of magnitude, are
+ * commonly set by boot scripts, and nothing tells when one of them did not
+ * run.  The CFG_DEVLINK_PARAMS key declares the desired value of parameters
+ * per devlink device as "bus/dev/name=value" entries separated by commas or
+ * spaces.  We set each parameter in its runtime configuration mode, or in
+ * its driverinit mode should it have no runtime one, read it back, and check
+ * it again periodically so that a device which is reloaded or appears late
+ * is configured too.
+ *
+ * Like the other CFG_* keys, the profile is read from port_prepare, the
+ * main loop run callback has no access to the database.  Lports are held
+ * back until each entry of a new profile was checked once, so that no flow
+ * of a representor is offloaded before then. */
+struct devlink_param_entry {
+    struct ovs_list list_node;  /* In 'devlink_params'. */
+    char *bus_name;
+    char *dev_name;
+    char *name;
+    char *value;
+    int error;                  /* Outcome of the last check. */
+    bool checked;               /* Checked at least once. */
+};
+
+#define DEVLINK_PARAMS_RUN_INTERVAL_MSEC 10000
+
+static struct ovs_list devlink_params = OVS_LIST_INITIALIZER(&devlink_params);
+static char *devlink_params_cfg;    /* Value 'devlink_params' was built of. */
+static long long int devlink_params_next_run;
+
+/* Time budget for work done per call to vif_plug_representor_run.
+ *
+ * Processing of the initial dump and of backlogs of notifications stops once
+ * the budget is exhausted, and resumes from the next call after an immediate
+ * wake up of the poll loop, so that the ovn-controller main loop latency
+ * stays bounded regardless of the amount of representor churn.  At least one
+ * unit of work is done per call to guarantee progress.  A budget of 0 means
+ * unlimited.
+ *
+ * The budget is started by the call from the main loop, the calls made by
+ * port_prepare for each lport in the same iteration draw from it too rather
+ * than each getting a budget of their own. */
+#define RUN_BUDGET_MSEC_DEFAULT 10
+static unsigned int run_budget_msec = RUN_BUDGET_MSEC_DEFAULT;
+static long long int run_deadline;
+
+static long long int
+run_budget_deadline(void)
 {
-    struct port_node *pn;
+    return run_budget_msec ? time_msec() + run_budget_msec : LLONG_MAX;
+}
 
-    pn = xmalloc(sizeof *pn);
+/* Returns true if work should stop for now, having processed 'n_done' units
+ * of work with 'deadline', and arranges for an immediate wake up to resume
+ * it. */
+static bool
+run_budget_exhausted(long long int deadline, size_t n_done)
+{
+    if (n_done && deadline != LLONG_MAX && time_msec() >= deadline) {
+        poll_immediate_wake();
+        return true;
+    }
+    return false;
+}
+
+static struct sset maintained_iface_options =
+    SSET_INITIALIZER(&maintained_iface_options);
+
+/* Bounded wait for rename of netdevs created at runtime.
+ *
+ * To avoid refusing to plug a port indefinitely when a rename never comes,
+ * for example because no predictable naming rule matches the device, each
+ * wait is given a deadline.  On expiry the current name of the netdev is
+ * re-resolved from the kernel and accepted.
+ *
+ * As every wait has the same timeout, deadlines expire in the order the
+ * waits were started, and a FIFO list ordered by start time serves as our
+ * timer wheel. */
+#define RENAME_WAIT_TIMEOUT_MSEC 5000
+
+static struct ovs_list rename_wait_list =
+    OVS_LIST_INITIALIZER(&rename_wait_list);
+
+static struct {
+    unsigned long long int n_renamed;  /* Waits ended by a rename. */
+    unsigned long long int n_expired;  /* Waits ended by the deadline. */
+    unsigned long long int n_resolved; /* Expired waits where the kernel
+                                        * reported a different name. */
+    long long int total_msec;
+    long long int max_msec;
+} rename_wait_stats;
+
+/* A devlink port to retrieve with devlink_port_get_batch. */
+struct devlink_port_query {
+    const char *bus_name;
+    const char *dev_name;
+    uint32_t port_index;        /* UINT32_MAX if not known. */
+    int error;                  /* 0 if 'port_entry' was retrieved. */
+    struct dl_port port_entry;
+};
+
+static struct nl_dl_batch *devlink_port_get_batch(
+    struct devlink_port_query *, size_t n);
+static void port_table_update_devlink_port(struct dl_port *,
+                                           enum port_node_source);
+
+/* Publishes a new snapshot of the keys of 'pn' for lock-free readers.  Must
+ * be called whenever 'netdev_ifindex', 'netdev_name' or 'mac' of 'pn', or
+ * the MAC of its PF, changes, and before 'pn' is inserted in an index under
+ * the new key. */
+static void
+port_node_publish(struct port_node *pn)
+{
+    struct port_keys *old = ovsrcu_get_protected(struct port_keys *,
+                                                 &pn->keys);
+    size_t name_len = strlen(pn->netdev_name);
+    struct port_keys *keys;
+
+    keys = xmalloc(sizeof *keys + name_len + 1);
+    keys->netdev_ifindex = pn->netdev_ifindex;
+    keys->mac = pn->mac;
+    keys->pf_mac = port_node_is_phy(pn)
+                   ? pn->mac : function_node_cast(pn)->pf->up.mac;
+    memcpy(keys->netdev_name, pn->netdev_name, name_len + 1);
+    ovsrcu_set(&pn->keys, keys);
+    if (old) {
+        ovsrcu_postpone(free, old);
+    }
+}
+
+/* Returns the current keys of 'pn'.  Safe to call without 'port_table_mutex'
+ * held, the returned snapshot remains valid until the caller's next
+ * quiescent period. */
+static const struct port_keys *
+port_node_keys(const struct port_node *pn)
+{
+    return ovsrcu_get(struct port_keys *, &pn->keys);
+}
+
+static void
+port_node_init(struct port_node *pn, uint32_t netdev_ifindex,
+               const char *netdev_name, uint32_t number, uint16_t flavour,
+               struct eth_addr mac, enum port_node_source port_node_source)
+{
+    ovsrcu_init(&pn->keys, NULL);
     pn->netdev_ifindex = netdev_ifindex;
     pn->netdev_name = xstrdup(netdev_name);
     pn->netdev_renamed = false;
     pn->number = number;
     pn->flavour = flavour;
     pn->mac = mac;
-    pn->pf = pf;
     pn->port_node_source = port_node_source;
+    ovs_list_init(&pn->rename_wait_node);
+    pn->rename_wait_start = 0;
+    pn->dl_port_index = UINT32_MAX;
+    pn->resync_stale = false;
+#ifdef RENAME_TRACKING
+    if (port_node_source == PORT_NODE_SOURCE_RUNTIME) {
+        pn->rename_wait_start = time_msec();
+        ovs_list_push_back(&rename_wait_list, &pn->rename_wait_node);
+    }
+#endif /* RENAME_TRACKING */
+}
 
-    return pn;
+static struct phy_node *
+phy_node_create(const char *bus_name, const char *dev_name,
+                uint32_t netdev_ifindex, const char *netdev_name,
+                uint32_t number, uint16_t flavour, struct eth_addr mac,
+                enum port_node_source port_node_source)
+{
+    struct phy_node *phy;
+
+    phy = xmalloc(sizeof *phy);
+    port_node_init(&phy->up, netdev_ifindex, netdev_name, number, flavour,
+                   mac, port_node_source);
+    phy->bus_name = xstrdup(bus_name);
+    phy->dev_name = xstrdup(dev_name);
+    ovs_list_init(&phy->children);
+    ovs_list_init(&phy->sf_requests);
+    phy->compat_pf_mac = eth_addr_zero;
+    phy->compat_pf_mac_valid = false;
+    phy->compat_pf_mac_next = LLONG_MAX;
+    phy->vf_bdf_base = PCI_BDF_NONE;
+    phy->vf_bdf_stride = 0;
+    phy->sriov_probed = false;
+    phy->controller = UINT32_MAX;
+    phy->external = false;
+    phy->sf_pool_next_num = SF_POOL_NUM_BASE;
+    port_node_publish(&phy->up);
+
+    return phy;
+}
+
+static struct function_node *
+function_node_create(struct phy_node *pf, uint32_t netdev_ifindex,
+                     const char *netdev_name, uint32_t number,
+                     uint16_t flavour, struct eth_addr mac,
+                     enum port_node_source port_node_source)
+{
+    struct function_node *fn;
+
+    fn = xmalloc(sizeof *fn);
+    port_node_init(&fn->up, netdev_ifindex, netdev_name, number, flavour,
+                   mac, port_node_source);
+    fn->mac_vf_hash = 0;
+    fn->pf = pf;
+    fn->bdf = PCI_BDF_NONE;
+    fn->rate = NULL;
+    fn->provisioned = false;
+    ovs_list_push_back(&pf->children, &fn->pf_node);
+    port_node_publish(&fn->up);
+
+    return fn;
 }
 
 static void
-port_node_destroy(struct port_node *pn)
+port_node_rename_wait_cancel(struct port_node *pn)
 {
-    if (pn->netdev_name) {
-        free(pn->netdev_name);
+    if (!ovs_list_is_empty(&pn->rename_wait_node)) {
+        ovs_list_remove(&pn->rename_wait_node);
+        ovs_list_init(&pn->rename_wait_node);
     }
-    free(pn);
+}
+
+static void
+port_node_rename_wait_done(struct port_node *pn, long long int now,
+                           bool expired)
+{
+    long long int waited;
+
+    if (ovs_list_is_empty(&pn->rename_wait_node)) {
+        return;
+    }
+    port_node_rename_wait_cancel(pn);
+
+    waited = now - pn->rename_wait_start;
+    if (expired) {
+        rename_wait_stats.n_expired++;
+    } else {
+        rename_wait_stats.n_renamed++;
+    }
+    rename_wait_stats.total_msec += waited;
+    rename_wait_stats.max_msec = MAX(rename_wait_stats.max_msec, waited);
+}
+
+static void phy_node_compat_invalidate(struct phy_node *);
+
+static void
+phy_node_free(struct phy_node *phy)
+{
+    free(ovsrcu_get_protected(struct port_keys *, &phy->up.keys));
+    free(phy->up.netdev_name);
+    free(phy->bus_name);
+    free(phy->dev_name);
+    free(phy);
+}
+
+static void
+function_node_free(struct function_node *fn)
+{
+    if (fn->rate) {
+        free(fn->rate->parent);
+        free(fn->rate);
+    }
+    free(ovsrcu_get_protected(struct port_keys *, &fn->up.keys));
+    free(fn->up.netdev_name);
+    free(fn);
+}
+
+/* Destroys 'phy', which must already have been removed from the indexes of
+ * the port table.  Concurrent readers may still hold a reference, so the
+ * memory is freed after an RCU grace period. */
+static void
+phy_node_destroy(struct phy_node *phy)
+{
+    struct sf_request *req;
+
+    port_node_rename_wait_cancel(&phy->up);
+    phy_node_compat_invalidate(phy);
+    LIST_FOR_EACH_POP (req, list_node, &phy->sf_requests) {
+        free(req);
+    }
+    ovsrcu_postpone(phy_node_free, phy);
+}
+
+/* Same as phy_node_destroy, for functions. */
+static void
+function_node_destroy(struct function_node *fn)
+{
+    port_node_rename_wait_cancel(&fn->up);
+    ovs_list_remove(&fn->pf_node);
+    ovsrcu_postpone(function_node_free, fn);
 }
 
 static void
 port_node_update(struct port_node *pn, const char *netdev_name)
 {
+    if (pn->netdev_name && strcmp(pn->netdev_name, netdev_name)
+        && port_node_is_phy(pn)) {
+        /* The compat sysfs path is relative to the netdev name. */
+        phy_node_compat_invalidate(phy_node_cast(pn));
+    }
     if (pn->netdev_name) {
-        free (pn->netdev_name);
+        ovsrcu_postpone(free, pn->netdev_name);
         pn->netdev_renamed = true;
+        port_node_rename_wait_done(pn, time_msec(), false);
     }
     pn->netdev_name = xstrdup(netdev_name);
+    if (ovsrcu_get_protected(struct port_keys *, &pn->keys)) {
+        port_node_publish(pn);
+    }
+}
+
+/* A node restored from snapshot takes on the source of the first update
+ * confirming its existence. */
+static void
+port_node_confirm(struct port_node *pn, enum port_node_source port_node_source)
+{
+    if (pn->port_node_source == PORT_NODE_SOURCE_SNAPSHOT) {
+        pn->port_node_source = port_node_source;
+    }
 }
 
 static bool
 port_node_rename_expected(struct port_node *pn)
 {
-#ifdef HAVE_UDEV
+#ifdef RENAME_TRACKING
     return pn->port_node_source == PORT_NODE_SOURCE_RUNTIME
            && pn->netdev_renamed == false;
 #else
     return false;
-#endif /* HAVE_UDEV */
+#endif /* RENAME_TRACKING */
+
+}
+
+static void
+rename_wait_stats_unixctl(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                          const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    unsigned long long int n_done;
+
+    /* The monitor thread updates the list and the statistics. */
+    ovs_mutex_lock(&port_table_mutex);
+    n_done = rename_wait_stats.n_renamed + rename_wait_stats.n_expired;
+    ds_put_format(&ds, "waiting: %"PRIuSIZE"\n",
+                  ovs_list_size(&rename_wait_list));
+    ds_put_format(&ds, "renamed: %llu\n", rename_wait_stats.n_renamed);
+    ds_put_format(&ds, "expired: %llu\n", rename_wait_stats.n_expired);
+    ds_put_format(&ds, "resolved on expiry: %llu\n",
+                  rename_wait_stats.n_resolved);
+    ds_put_format(&ds, "average wait: %lld ms\n",
+                  n_done ? rename_wait_stats.total_msec / (long long) n_done
+                         : 0);
+    ds_put_format(&ds, "maximum wait: %lld ms\n",
+                  rename_wait_stats.max_msec);
+    ovs_mutex_unlock(&port_table_mutex);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+}
+
+/* Buffer of recent netdev names for ifindexes not (yet) in the port table.
+ *
+ * The rename of a netdev may be reported to us before the devlink
+ * notification about the port it belongs to, in which case the port would be
+ * inserted with its pre-rename name and wait for a rename that already
+ * happened.  To make the ordering irrelevant we remember the latest name of
+ * unknown ifindexes for a short while, and consult the buffer whenever a port
+ * is inserted into the table.
+ *
+ * Entries expire after RENAME_BUFFER_TTL_MSEC, and the number of entries is
+ * capped so that a burst of link events for unrelated netdevs can not grow it
+ * without bounds.  As all entries have the same time to live, the list is
+ * ordered by expiry. */
+#define RENAME_BUFFER_TTL_MSEC 10000
+#define RENAME_BUFFER_MAX 1024
+
+struct rename_buffer_entry {
+    struct hmap_node hmap_node;  /* In 'rename_buffer', by ifindex. */
+    struct ovs_list list_node;   /* In 'rename_buffer_list'. */
+    uint32_t netdev_ifindex;
+    char netdev_name[IFNAMSIZ];
+    bool renamed;                /* Entry records an actual rename. */
+    long long int expires;
+};
+
+static struct hmap rename_buffer = HMAP_INITIALIZER(&rename_buffer);
+static struct ovs_list rename_buffer_list =
+    OVS_LIST_INITIALIZER(&rename_buffer_list);
+
+static struct rename_buffer_entry *
+rename_buffer_lookup(uint32_t netdev_ifindex)
+{
+    struct rename_buffer_entry *e;
+
+    HMAP_FOR_EACH_WITH_HASH (e, hmap_node, netdev_ifindex, &rename_buffer) {
+        if (e->netdev_ifindex == netdev_ifindex) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void
+rename_buffer_remove(struct rename_buffer_entry *e)
+{
+    hmap_remove(&rename_buffer, &e->hmap_node);
+    ovs_list_remove(&e->list_node);
+    free(e);
+}
+
+static void
+rename_buffer_expire(long long int now)
+{
+    while (!ovs_list_is_empty(&rename_buffer_list)) {
+        struct rename_buffer_entry *e;
+
+        e = CONTAINER_OF(ovs_list_front(&rename_buffer_list),
+                         struct rename_buffer_entry, list_node);
+        if (e->expires > now) {
+            break;
+        }
+        rename_buffer_remove(e);
+    }
+}
+
+/* Records 'netdev_name' as the latest name of the netdev with
+ * 'netdev_ifindex', which is not present in the port table.  'renamed' tells
+ * whether the event is known to be a rename, otherwise it is deduced from the
+ * name differing from a previously recorded one. */
+static void OVS_UNUSED
+rename_buffer_record(uint32_t netdev_ifindex, const char *netdev_name,
+                     bool renamed)
+{
+    long long int now = time_msec();
+    struct rename_buffer_entry *e;
+
+    rename_buffer_expire(now);
+
+    e = rename_buffer_lookup(netdev_ifindex);
+    if (e) {
+        renamed = renamed || e->renamed || strcmp(e->netdev_name, netdev_name);
+        ovs_list_remove(&e->list_node);
+    } else {
+        if (hmap_count(&rename_buffer) >= RENAME_BUFFER_MAX) {
+            rename_buffer_remove(
+                CONTAINER_OF(ovs_list_front(&rename_buffer_list),
+                             struct rename_buffer_entry, list_node));
+        }
+        e = xmalloc(sizeof *e);
+        e->netdev_ifindex = netdev_ifindex;
+        hmap_insert(&rename_buffer, &e->hmap_node, netdev_ifindex);
+    }
+    ovs_strzcpy(e->netdev_name, netdev_name, sizeof e->netdev_name);
+    e->renamed = renamed;
+    e->expires = now + RENAME_BUFFER_TTL_MSEC;
+    ovs_list_push_back(&rename_buffer_list, &e->list_node);
+}
+
+static void
+rename_buffer_clear(void)
+{
+    struct rename_buffer_entry *e;
+
+    HMAP_FOR_EACH_POP (e, hmap_node, &rename_buffer) {
+        ovs_list_remove(&e->list_node);
+        free(e);
+    }
+}
+
+/* Applies any rename recorded for the netdev of the newly inserted port
+ * 'pn'. */
+static void
+port_node_rename_buffer_apply(struct port_node *pn)
+{
+    struct rename_buffer_entry *e;
+
+    rename_buffer_expire(time_msec());
 
+    e = rename_buffer_lookup(pn->netdev_ifindex);
+    if (!e) {
+        return;
+    }
+    if (strcmp(e->netdev_name, pn->netdev_name)) {
+        VLOG_DBG("applying early rename of netdev with ifindex %"PRIu32
+                 " from %s to %s",
+                 pn->netdev_ifindex, pn->netdev_name, e->netdev_name);
+        port_node_update(pn, e->netdev_name);
+    } else if (e->renamed) {
+        /* The port was inserted with the post-rename name. */
+        pn->netdev_renamed = true;
+        port_node_rename_wait_done(pn, time_msec(), false);
+    }
+    rename_buffer_remove(e);
 }
 
 static struct port_table *
@@ -154,35 +884,68 @@ port_table_create(void)
     struct port_table *tbl;
 
     tbl = xmalloc(sizeof *tbl);
-    hmap_init(&tbl->mac_vf_table);
+    cmap_init(&tbl->mac_vf_table);
     tbl->mac_seed = random_uint32();
-    hmap_init(&tbl->ifindex_table);
-    hmap_init(&tbl->bus_dev_table);
+    cmap_init(&tbl->ifindex_table);
+    cmap_init(&tbl->bus_dev_table);
+    cmap_init(&tbl->function_mac_table);
+    cmap_init(&tbl->bdf_table);
+    hmap_init(&tbl->pending_table);
 
     return tbl;
 }
 
 static void
-port_table_destroy(struct port_table *tbl)
+pending_function_destroy(struct pending_function *fn)
 {
-    struct port_node *port_node;
-    HMAP_FOR_EACH_POP (port_node, mac_vf_node, &tbl->mac_vf_table) {
-        port_node_destroy(port_node);
-    }
-    hmap_destroy(&tbl->mac_vf_table);
+    free(fn->netdev_name);
+    free(fn);
+}
+
+static void
+pending_pf_destroy(struct port_table *tbl, struct pending_pf *ppf)
+{
+    struct pending_function *fn;
 
-    /* The PHYSICAL and PF ports are stored in both ifindex_table and
-     * bus_dev_table */
-    HMAP_FOR_EACH_POP (port_node, bus_dev_node, &tbl->bus_dev_table) {
-        port_node_destroy(port_node);
+    LIST_FOR_EACH_POP (fn, list_node, &ppf->functions) {
+        pending_function_destroy(fn);
     }
-    hmap_destroy(&tbl->bus_dev_table);
+    hmap_remove(&tbl->pending_table, &ppf->hmap_node);
+    free(ppf->bus_name);
+    free(ppf->dev_name);
+    free(ppf);
+}
+
+static void port_table_remove_function(struct port_table *,
+                                      struct function_node *);
+static void port_table_remove_phy(struct port_table *, struct phy_node *);
+
+static void
+port_table_destroy(struct port_table *tbl)
+{
+    struct function_node *fn;
+    struct phy_node *phy;
 
-    /* All entries in the ifindex table are also in the mac_vf table or
-     * bus_dev_table which nodes were destroyed above, so we only
-     * need to destroy the hmap data for the ifindex table. */
-    hmap_destroy(&tbl->ifindex_table);
-    free(tbl);
+    /* Functions first, so that we never leave a function referring to a
+     * removed PF. */
+    CMAP_FOR_EACH (fn, mac_vf_node, &tbl->mac_vf_table) {
+        port_table_remove_function(tbl, fn);
+    }
+    CMAP_FOR_EACH (phy, bus_dev_node, &tbl->bus_dev_table) {
+        port_table_remove_phy(tbl, phy);
+    }
+    cmap_destroy(&tbl->mac_vf_table);
+    cmap_destroy(&tbl->bus_dev_table);
+    cmap_destroy(&tbl->ifindex_table);
+    cmap_destroy(&tbl->function_mac_table);
+    cmap_destroy(&tbl->bdf_table);
+
+    struct pending_pf *ppf;
+    HMAP_FOR_EACH_SAFE (ppf, hmap_node, &tbl->pending_table) {
+        pending_pf_destroy(tbl, ppf);
+    }
+    hmap_destroy(&tbl->pending_table);
+    ovsrcu_postpone(free, tbl);
 }
 
 static uint32_t port_table_hash_mac_vf(const struct port_table *tbl,
@@ -192,14 +955,35 @@ static uint32_t port_table_hash_mac_vf(const struct port_table *tbl,
     return hash_mac(mac, vf_num, tbl->mac_seed);
 }
 
+/* Returns the hash of a function in 'mac_vf_table'.  SF numbers are 32 bits
+ * wide and form a number space separate from VF numbers, so they are mixed
+ * into the basis instead. */
+static uint32_t
+port_table_hash_function(const struct port_table *tbl,
+                         const struct eth_addr pf_mac, uint16_t flavour,
+                         uint32_t number)
+{
+    if (flavour == DEVLINK_PORT_FLAVOUR_PCI_SF) {
+        return hash_mac(pf_mac, 0, hash_int(number, tbl->mac_seed));
+    }
+    return port_table_hash_mac_vf(tbl, pf_mac, number);
+}
+
+static uint32_t
+port_table_hash_function_mac(const struct port_table *tbl,
+                             const struct eth_addr mac)
+{
+    return hash_mac(mac, 0, tbl->mac_seed);
+}
+
 static struct port_node *
 port_table_lookup_ifindex(struct port_table *tbl, uint32_t netdev_ifindex)
 {
     struct port_node *pn;
 
-    HMAP_FOR_EACH_WITH_HASH (pn, ifindex_node, netdev_ifindex,
-                            &tbl->ifindex_table) {
-        if (pn->netdev_ifindex == netdev_ifindex) {
+    CMAP_FOR_EACH_WITH_HASH (pn, ifindex_node, netdev_ifindex,
+                             &tbl->ifindex_table) {
+        if (port_node_keys(pn)->netdev_ifindex == netdev_ifindex) {
             return pn;
         }
     }
@@ -210,14 +994,79 @@ static struct port_node *
 port_table_lookup_pf_mac_vf(struct port_table *tbl, struct eth_addr mac,
                             uint16_t vf_num)
 {
-    struct port_node *pn;
+    struct function_node *fn;
 
-    HMAP_FOR_EACH_WITH_HASH (pn, mac_vf_node,
+    CMAP_FOR_EACH_WITH_HASH (fn, mac_vf_node,
                              port_table_hash_mac_vf(tbl, mac, vf_num),
                              &tbl->mac_vf_table) {
-        if (pn->number == vf_num && pn->pf
-            && eth_addr_equals(pn->pf->mac, mac)) {
-            return pn;
+        if (fn->up.flavour == DEVLINK_PORT_FLAVOUR_PCI_VF
+            && fn->up.number == vf_num
+            && eth_addr_equals(port_node_keys(&fn->up)->pf_mac, mac)) {
+            return &fn->up;
+        }
+    }
+    return NULL;
+}
+
+static struct port_node *
+port_table_lookup_pf_mac_sf(struct port_table *tbl, struct eth_addr mac,
+                            uint32_t sf_num)
+{
+    struct function_node *fn;
+
+    CMAP_FOR_EACH_WITH_HASH (fn, mac_vf_node,
+                             port_table_hash_function(
+                                 tbl, mac, DEVLINK_PORT_FLAVOUR_PCI_SF,
+                                 sf_num),
+                             &tbl->mac_vf_table) {
+        if (fn->up.flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+            && fn->up.number == sf_num
+            && eth_addr_equals(port_node_keys(&fn->up)->pf_mac, mac)) {
+            return &fn->up;
+        }
+    }
+    return NULL;
+}
+
+/* Returns the function of flavour 'flavour' and number 'number' of PF
+ * 'pf'. */
+static struct port_node *
+port_table_lookup_function(struct port_table *tbl, const struct phy_node *pf,
+                           uint16_t flavour, uint32_t number)
+{
+    struct eth_addr mac = port_node_keys(&pf->up)->mac;
+
+    return flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+           ? port_table_lookup_pf_mac_sf(tbl, mac, number)
+           : port_table_lookup_pf_mac_vf(tbl, mac, number);
+}
+
+/* Returns the function whose host facing MAC is 'mac'.  Should several
+ * functions share a MAC, which one is returned is unspecified. */
+static struct port_node *
+port_table_lookup_function_mac(struct port_table *tbl, struct eth_addr mac)
+{
+    struct function_node *fn;
+
+    CMAP_FOR_EACH_WITH_HASH (fn, function_mac_node,
+                             port_table_hash_function_mac(tbl, mac),
+                             &tbl->function_mac_table) {
+        if (eth_addr_equals(port_node_keys(&fn->up)->mac, mac)) {
+            return &fn->up;
+        }
+    }
+    return NULL;
+}
+
+static struct port_node *
+port_table_lookup_bdf(struct port_table *tbl, uint32_t bdf)
+{
+    struct function_node *fn;
+
+    CMAP_FOR_EACH_WITH_HASH (fn, bdf_node, hash_int(bdf, 0),
+                             &tbl->bdf_table) {
+        if (fn->bdf == bdf) {
+            return &fn->up;
         }
     }
     return NULL;
@@ -236,50 +1085,466 @@ hash_bus_dev(const char *bus_name, const char *dev_name)
     return hash_string(bus_dev, 0);
 }
 
-static struct port_node *
+static struct phy_node *
 port_table_lookup_phy_bus_dev(struct port_table *tbl,
                               const char *bus_name, const char *dev_name,
                               uint16_t flavour, uint32_t number)
 {
-    struct port_node *pn;
-    HMAP_FOR_EACH_WITH_HASH (pn, bus_dev_node,
+    struct phy_node *phy;
+    CMAP_FOR_EACH_WITH_HASH (phy, bus_dev_node,
                              hash_bus_dev(bus_name, dev_name),
                              &tbl->bus_dev_table) {
-       if (pn->flavour == flavour && pn->number == number) {
-           return pn;
+       if (phy->up.flavour == flavour && phy->up.number == number
+           && !strcmp(phy->bus_name, bus_name)
+           && !strcmp(phy->dev_name, dev_name)) {
+           return phy;
        }
     }
     return NULL;
 }
 
-
-static struct port_node *
-port_table_update_phy__(struct port_table *tbl,
-                        const char *bus_name, const char *dev_name,
-                        uint32_t netdev_ifindex, const char *netdev_name,
-                        uint32_t number, uint16_t flavour,
-                        struct eth_addr mac,
-                        enum port_node_source port_node_source)
+/* Returns the PF whose host facing MAC is 'mac'.  There are only a handful
+ * of PFs, so walking them is cheaper than maintaining another index. */
+static struct phy_node *
+port_table_lookup_pf_mac(struct port_table *tbl, struct eth_addr mac)
 {
-    struct port_node *pn;
+    struct phy_node *phy;
 
-    pn = port_table_lookup_phy_bus_dev(tbl, bus_name, dev_name,
-                                       flavour, number);
-    if (!pn) {
-        pn = port_node_create(netdev_ifindex, netdev_name,
-                              number, flavour, mac, NULL, port_node_source);
-        hmap_insert(&tbl->ifindex_table, &pn->ifindex_node, netdev_ifindex);
-        hmap_insert(&tbl->bus_dev_table, &pn->bus_dev_node,
-                    hash_bus_dev(bus_name, dev_name));
-    } else {
-        port_node_update(pn, netdev_name);
+    CMAP_FOR_EACH (phy, bus_dev_node, &tbl->bus_dev_table) {
+        if (phy->up.flavour == DEVLINK_PORT_FLAVOUR_PCI_PF
+            && eth_addr_equals(port_node_keys(&phy->up)->mac, mac)) {
+            return phy;
+        }
     }
+    return NULL;
+}
 
-    return pn;
+
+static struct pending_pf *
+port_table_lookup_pending_pf(struct port_table *tbl,
+                             const char *bus_name, const char *dev_name,
+                             uint16_t pci_pf_number)
+{
+    struct pending_pf *ppf;
+
+    HMAP_FOR_EACH_WITH_HASH (ppf, hmap_node,
+                             hash_bus_dev(bus_name, dev_name) ^ pci_pf_number,
+                             &tbl->pending_table) {
+        if (ppf->pci_pf_number == pci_pf_number
+            && !strcmp(ppf->bus_name, bus_name)
+            && !strcmp(ppf->dev_name, dev_name)) {
+            return ppf;
+        }
+    }
+    return NULL;
+}
+
+static struct pending_function *
+pending_pf_find_function(struct pending_pf *ppf, uint16_t flavour,
+                         uint32_t number)
+{
+    struct pending_function *fn;
+
+    LIST_FOR_EACH (fn, list_node, &ppf->functions) {
+        if (fn->flavour == flavour && fn->number == number) {
+            return fn;
+        }
+    }
+    return NULL;
+}
+
+/* Parks a function until its PF is known, replacing any previous record of
+ * the same function, and returns the record. */
+static struct pending_function *
+port_table_add_pending(struct port_table *tbl,
+                       const char *bus_name, const char *dev_name,
+                       uint32_t netdev_ifindex, const char *netdev_name,
+                       uint16_t pci_pf_number, uint32_t number,
+                       uint16_t flavour, struct eth_addr mac,
+                       enum port_node_source port_node_source)
+{
+    struct pending_function *fn;
+    struct pending_pf *ppf;
+
+    ppf = port_table_lookup_pending_pf(tbl, bus_name, dev_name,
+                                       pci_pf_number);
+    if (!ppf) {
+        ppf = xmalloc(sizeof *ppf);
+        ppf->bus_name = xstrdup(bus_name);
+        ppf->dev_name = xstrdup(dev_name);
+        ppf->pci_pf_number = pci_pf_number;
+        ovs_list_init(&ppf->functions);
+        hmap_insert(&tbl->pending_table, &ppf->hmap_node,
+                    hash_bus_dev(bus_name, dev_name) ^ pci_pf_number);
+    }
+
+    fn = pending_pf_find_function(ppf, flavour, number);
+    if (fn) {
+        free(fn->netdev_name);
+    } else {
+        fn = xmalloc(sizeof *fn);
+        fn->number = number;
+        fn->flavour = flavour;
+        fn->detached = false;
+        fn->parked = time_msec();
+        ovs_list_push_back(&ppf->functions, &fn->list_node);
+    }
+    fn->netdev_ifindex = netdev_ifindex;
+    fn->netdev_name = xstrdup(netdev_name);
+    fn->mac = mac;
+    fn->port_node_source = port_node_source;
+
+    VLOG_DBG("function %s reported before PF %s/%s %"PRIu16", deferring "
+             "insert until PF is known",
+             netdev_name, bus_name, dev_name, pci_pf_number);
+    return fn;
+}
+
+/* Drops the functions parked for longer than PENDING_TIMEOUT_MSEC at
+ * 'now'. */
+static void
+port_table_pending_run(struct port_table *tbl, long long int now)
+{
+    struct pending_pf *ppf;
+
+    HMAP_FOR_EACH_SAFE (ppf, hmap_node, &tbl->pending_table) {
+        struct pending_function *fn;
+
+        LIST_FOR_EACH_SAFE (fn, list_node, &ppf->functions) {
+            if (now >= fn->parked + PENDING_TIMEOUT_MSEC) {
+                VLOG_INFO("dropping function %s, its PF %s/%s %"PRIu16" did "
+                          "not appear within %d ms", fn->netdev_name,
+                          ppf->bus_name, ppf->dev_name, ppf->pci_pf_number,
+                          PENDING_TIMEOUT_MSEC);
+                ovs_list_remove(&fn->list_node);
+                pending_function_destroy(fn);
+            } else {
+                poll_timer_wait_until(fn->parked + PENDING_TIMEOUT_MSEC);
+            }
+        }
+        if (ovs_list_is_empty(&ppf->functions)) {
+            pending_pf_destroy(tbl, ppf);
+        }
+    }
+}
+
+/* Removes a parked function, returns true if it was found. */
+static bool
+port_table_remove_pending(struct port_table *tbl,
+                          const char *bus_name, const char *dev_name,
+                          uint16_t pci_pf_number, uint16_t flavour,
+                          uint32_t number)
+{
+    struct pending_function *fn;
+    struct pending_pf *ppf;
+
+    ppf = port_table_lookup_pending_pf(tbl, bus_name, dev_name,
+                                       pci_pf_number);
+    if (!ppf) {
+        return false;
+    }
+    fn = pending_pf_find_function(ppf, flavour, number);
+    if (!fn) {
+        return false;
+    }
+    ovs_list_remove(&fn->list_node);
+    pending_function_destroy(fn);
+    if (ovs_list_is_empty(&ppf->functions)) {
+        pending_pf_destroy(tbl, ppf);
+    }
+    return true;
+}
+
+static struct port_node *
+port_table_update_function__(struct port_table *, struct phy_node *pf,
+                             uint32_t netdev_ifindex, const char *netdev_name,
+                             uint32_t number, uint16_t flavour,
+                             struct eth_addr mac,
+                             enum port_node_source);
+
+/* Inserts all functions parked waiting for the PF 'phy'. */
+static void
+port_table_attach_pending(struct port_table *tbl, struct phy_node *phy)
+{
+    struct pending_function *fn;
+    struct pending_pf *ppf;
+
+    ppf = port_table_lookup_pending_pf(tbl, phy->bus_name, phy->dev_name,
+                                       phy->up.number);
+    if (!ppf) {
+        return;
+    }
+    VLOG_DBG("attaching %"PRIuSIZE" pending functions to PF %s",
+             ovs_list_size(&ppf->functions), phy->up.netdev_name);
+    LIST_FOR_EACH_POP (fn, list_node, &ppf->functions) {
+        struct port_node *pn;
+
+        pn = port_table_update_function__(tbl, phy, fn->netdev_ifindex,
+                                          fn->netdev_name, fn->number,
+                                          fn->flavour, fn->mac,
+                                          fn->port_node_source);
+        if (fn->detached) {
+            /* The netdev is not new, so there is no rename to wait for. */
+            port_node_rename_wait_cancel(pn);
+            pn->netdev_renamed = true;
+        }
+        pending_function_destroy(fn);
+    }
+    pending_pf_destroy(tbl, ppf);
+}
+
+/* Functions whose MAC is not set report all zeros, which would pile them up
+ * in a single hash chain, while a zero MAC is never looked up. */
+static void
+port_table_index_function_mac(struct port_table *tbl,
+                              struct function_node *fn)
+{
+    if (!eth_addr_is_zero(fn->up.mac)) {
+        cmap_insert(&tbl->function_mac_table, &fn->function_mac_node,
+                    port_table_hash_function_mac(tbl, fn->up.mac));
+    }
+}
+
+static void
+port_table_forget_function_mac(struct port_table *tbl,
+                               struct function_node *fn)
+{
+    if (!eth_addr_is_zero(fn->up.mac)) {
+        cmap_remove(&tbl->function_mac_table, &fn->function_mac_node,
+                    port_table_hash_function_mac(tbl, fn->up.mac));
+    }
+}
+
+/* Removes function 'fn' from the table and destroys it. */
+static void
+port_table_remove_function(struct port_table *tbl, struct function_node *fn)
+{
+    cmap_remove(&tbl->ifindex_table, &fn->up.ifindex_node,
+                fn->up.netdev_ifindex);
+    cmap_remove(&tbl->mac_vf_table, &fn->mac_vf_node, fn->mac_vf_hash);
+    port_table_forget_function_mac(tbl, fn);
+    if (fn->bdf != PCI_BDF_NONE) {
+        cmap_remove(&tbl->bdf_table, &fn->bdf_node, hash_int(fn->bdf, 0));
+    }
+    function_node_destroy(fn);
+}
+
+/* Moves 'pn' to 'netdev_ifindex', the netdev of a port gets a new ifindex
+ * when it is re-created, for example while ovn-controller was not running. */
+static void
+port_table_update_ifindex(struct port_table *tbl, struct port_node *pn,
+                          uint32_t netdev_ifindex)
+{
+    if (pn->netdev_ifindex == netdev_ifindex
+        || netdev_ifindex == UINT32_MAX) {
+        return;
+    }
+    cmap_remove(&tbl->ifindex_table, &pn->ifindex_node, pn->netdev_ifindex);
+    pn->netdev_ifindex = netdev_ifindex;
+    port_node_publish(pn);
+    cmap_insert(&tbl->ifindex_table, &pn->ifindex_node, netdev_ifindex);
+}
+
+/* Removes PHYSICAL or PF port 'phy' from the table and destroys it.  Any
+ * functions of a PF must have been removed first. */
+static void
+port_table_remove_phy(struct port_table *tbl, struct phy_node *phy)
+{
+    ovs_assert(ovs_list_is_empty(&phy->children));
+    cmap_remove(&tbl->ifindex_table, &phy->up.ifindex_node,
+                phy->up.netdev_ifindex);
+    cmap_remove(&tbl->bus_dev_table, &phy->bus_dev_node,
+                hash_bus_dev(phy->bus_name, phy->dev_name));
+    phy_node_destroy(phy);
+}
+
+/* Changes the MAC of PF 'pf' to 'mac', re-indexing its functions under the
+ * new MAC. */
+static void
+port_table_update_pf_mac(struct port_table *tbl, struct phy_node *pf,
+                         struct eth_addr mac)
+{
+    struct function_node *fn;
+
+    VLOG_INFO("MAC of PF %s changed from "ETH_ADDR_FMT" to "ETH_ADDR_FMT
+              ", re-indexing %"PRIuSIZE" functions.",
+              pf->up.netdev_name, ETH_ADDR_ARGS(pf->up.mac),
+              ETH_ADDR_ARGS(mac), ovs_list_size(&pf->children));
+    pf->up.mac = mac;
+    port_node_publish(&pf->up);
+    LIST_FOR_EACH (fn, pf_node, &pf->children) {
+        cmap_remove(&tbl->mac_vf_table, &fn->mac_vf_node, fn->mac_vf_hash);
+        fn->mac_vf_hash = port_table_hash_function(tbl, mac, fn->up.flavour,
+                                                   fn->up.number);
+        port_node_publish(&fn->up);
+        cmap_insert(&tbl->mac_vf_table, &fn->mac_vf_node, fn->mac_vf_hash);
+    }
+}
+
+/* Indexes function 'fn' by its host PCI address, if the SR-IOV layout of its
+ * PF is known. */
+static void
+port_table_index_function_bdf(struct port_table *tbl, struct function_node *fn)
+{
+    const struct phy_node *pf = fn->pf;
+    uint32_t bdf;
+
+    if (fn->bdf != PCI_BDF_NONE || pf->vf_bdf_base == PCI_BDF_NONE
+        || fn->up.flavour != DEVLINK_PORT_FLAVOUR_PCI_VF) {
+        return;
+    }
+    /* The routing ID of a VF must not overflow into the domain. */
+    bdf = pf->vf_bdf_base + fn->up.number * pf->vf_bdf_stride;
+    if (bdf >> 16 != pf->vf_bdf_base >> 16) {
+        return;
+    }
+    fn->bdf = bdf;
+    cmap_insert(&tbl->bdf_table, &fn->bdf_node, hash_int(bdf, 0));
+}
+
+/* Changes the host facing MAC of function 'fn' to 'mac'. */
+static void
+port_table_update_function_mac(struct port_table *tbl,
+                               struct function_node *fn, struct eth_addr mac)
+{
+    VLOG_DBG("MAC of function %s changed from "ETH_ADDR_FMT" to "
+             ETH_ADDR_FMT, fn->up.netdev_name, ETH_ADDR_ARGS(fn->up.mac),
+             ETH_ADDR_ARGS(mac));
+    port_table_forget_function_mac(tbl, fn);
+    fn->up.mac = mac;
+    port_node_publish(&fn->up);
+    port_table_index_function_mac(tbl, fn);
+}
+
+/* Moves the functions of PF 'pf', which is about to be removed, back to the
+ * pending list so that they are attached again should the PF reappear. */
+static void
+port_table_detach_children(struct port_table *tbl, struct phy_node *pf)
+{
+    struct function_node *fn;
+
+    LIST_FOR_EACH_POP (fn, pf_node, &pf->children) {
+        ovs_list_init(&fn->pf_node);
+        port_table_add_pending(tbl, pf->bus_name, pf->dev_name,
+                               fn->up.netdev_ifindex, fn->up.netdev_name,
+                               pf->up.number, fn->up.number, fn->up.flavour,
+                               fn->up.mac, fn->up.port_node_source)
+            ->detached = true;
+        port_table_remove_function(tbl, fn);
+    }
+}
+
+static struct port_node *
+port_table_update_phy__(struct port_table *tbl,
+                        const char *bus_name, const char *dev_name,
+                        uint32_t netdev_ifindex, const char *netdev_name,
+                        uint32_t number, uint16_t flavour,
+                        struct eth_addr mac,
+                        enum port_node_source port_node_source)
+{
+    struct phy_node *phy;
+
+    phy = port_table_lookup_phy_bus_dev(tbl, bus_name, dev_name,
+                                        flavour, number);
+    if (!phy) {
+        phy = phy_node_create(bus_name, dev_name, netdev_ifindex,
+                              netdev_name, number, flavour, mac,
+                              port_node_source);
+        cmap_insert(&tbl->ifindex_table, &phy->up.ifindex_node,
+                    netdev_ifindex);
+        cmap_insert(&tbl->bus_dev_table, &phy->bus_dev_node,
+                    hash_bus_dev(bus_name, dev_name));
+        port_node_rename_buffer_apply(&phy->up);
+        if (flavour == DEVLINK_PORT_FLAVOUR_PCI_PF) {
+            port_table_attach_pending(tbl, phy);
+        }
+    } else {
+        port_table_update_ifindex(tbl, &phy->up, netdev_ifindex);
+        port_node_update(&phy->up, netdev_name);
+        port_node_confirm(&phy->up, port_node_source);
+        if (!eth_addr_equals(phy->up.mac, mac)) {
+            if (flavour == DEVLINK_PORT_FLAVOUR_PCI_PF) {
+                port_table_update_pf_mac(tbl, phy, mac);
+            } else {
+                phy->up.mac = mac;
+                port_node_publish(&phy->up);
+            }
+        }
+    }
+
+    return &phy->up;
+}
+
+static struct sf_request *
+phy_node_find_sf_request(const struct phy_node *pf, uint32_t sf_num)
+{
+    struct sf_request *req;
+
+    LIST_FOR_EACH (req, list_node, &pf->sf_requests) {
+        if (req->sf_num == sf_num) {
+            return req;
+        }
+    }
+    return NULL;
+}
+
+static struct sf_request *
+phy_node_find_sf_request_mac(const struct phy_node *pf, struct eth_addr mac)
+{
+    struct sf_request *req;
+
+    LIST_FOR_EACH (req, list_node, &pf->sf_requests) {
+        if (eth_addr_equals(req->mac, mac)) {
+            return req;
+        }
+    }
+    return NULL;
+}
+
+/* Queues the creation of SF number 'sf_num' with host facing MAC 'mac' on
+ * PF 'pf'.  Returns false if it is queued already. */
+static bool
+phy_node_request_sf(struct phy_node *pf, uint32_t sf_num,
+                    struct eth_addr mac)
+{
+    struct sf_request *req;
+
+    if (phy_node_find_sf_request(pf, sf_num)) {
+        return false;
+    }
+    req = xmalloc(sizeof *req);
+    req->sf_num = sf_num;
+    req->mac = mac;
+    req->started = LLONG_MIN;
+    ovs_list_push_back(&pf->sf_requests, &req->list_node);
+    /* Requests are carried out from the main loop. */
+    poll_immediate_wake();
+    return true;
+}
+
+static void
+sf_request_destroy(struct sf_request *req)
+{
+    ovs_list_remove(&req->list_node);
+    free(req);
+}
+
+/* Forgets the request for SF number 'sf_num' of PF 'pf', whose representor
+ * was reported.  Returns true if there was such a request. */
+static bool
+phy_node_sf_request_done(struct phy_node *pf, uint32_t sf_num)
+{
+    struct sf_request *req = phy_node_find_sf_request(pf, sf_num);
+
+    if (req) {
+        sf_request_destroy(req);
+        return true;
+    }
+    return false;
 }
 
 static struct port_node *
-port_table_update_function__(struct port_table *tbl, struct port_node *pf,
+port_table_update_function__(struct port_table *tbl, struct phy_node *pf,
                              uint32_t netdev_ifindex, const char *netdev_name,
                              uint32_t number, uint16_t flavour,
                              struct eth_addr mac,
@@ -288,19 +1553,43 @@ port_table_update_function__(struct port_table *tbl, struct port_node *pf,
     struct port_node *pn = port_table_lookup_ifindex(tbl, netdev_ifindex);
 
     if (!pn) {
-        pn = port_node_create(
-            netdev_ifindex, netdev_name, number, flavour, mac, pf,
-            port_node_source);
-        hmap_insert(&tbl->ifindex_table, &pn->ifindex_node, netdev_ifindex);
-        hmap_insert(&tbl->mac_vf_table, &pn->mac_vf_node,
-                    port_table_hash_mac_vf(tbl, pf->mac, number));
+        /* The netdev of a known function may have been re-created. */
+        pn = flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+             ? port_table_lookup_pf_mac_sf(tbl, pf->up.mac, number)
+             : port_table_lookup_pf_mac_vf(tbl, pf->up.mac, number);
+        if (pn) {
+            port_table_update_ifindex(tbl, pn, netdev_ifindex);
+        }
+    }
+    if (!pn) {
+        struct function_node *fn;
+
+        fn = function_node_create(pf, netdev_ifindex, netdev_name, number,
+                                  flavour, mac, port_node_source);
+        fn->mac_vf_hash = port_table_hash_function(tbl, pf->up.mac, flavour,
+                                                   number);
+        cmap_insert(&tbl->ifindex_table, &fn->up.ifindex_node,
+                    netdev_ifindex);
+        cmap_insert(&tbl->mac_vf_table, &fn->mac_vf_node, fn->mac_vf_hash);
+        port_table_index_function_mac(tbl, fn);
+        port_table_index_function_bdf(tbl, fn);
+        if (flavour == DEVLINK_PORT_FLAVOUR_PCI_SF) {
+            fn->provisioned = phy_node_sf_request_done(pf, number);
+        }
+        port_node_rename_buffer_apply(&fn->up);
+        pn = &fn->up;
     } else {
         port_node_update(pn, netdev_name);
+        port_node_confirm(pn, port_node_source);
+        if (!port_node_is_phy(pn) && !eth_addr_equals(pn->mac, mac)) {
+            port_table_update_function_mac(tbl, function_node_cast(pn), mac);
+        }
     }
     return pn;
 }
 
-/* Inserts or updates an entry in the table. */
+/* Inserts or updates an entry in the table.  'number' is the port number of
+ * PHYSICAL ports and the SF number of PCI_SF ports. */
 static struct port_node *
 port_table_update_entry(struct port_table *tbl,
                         const char *bus_name, const char *dev_name,
@@ -318,16 +1607,20 @@ port_table_update_entry(struct port_table *tbl,
             flavour, mac, port_node_source);
     }
 
-    struct port_node *phy;
+    uint32_t fn_number = flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+                         ? number : pci_vf_number;
+    struct phy_node *phy;
     phy = port_table_lookup_phy_bus_dev(tbl, bus_name, dev_name,
                                         DEVLINK_PORT_FLAVOUR_PCI_PF,
                                         pci_pf_number);
     if (!phy) {
-        VLOG_WARN("attempt to add function before having knowledge about PF");
+        port_table_add_pending(tbl, bus_name, dev_name, netdev_ifindex,
+                               netdev_name, pci_pf_number, fn_number,
+                               flavour, mac, port_node_source);
         return NULL;
     }
     return port_table_update_function__(tbl, phy, netdev_ifindex, netdev_name,
-                                        pci_vf_number, flavour, mac,
+                                        fn_number, flavour, mac,
                                         port_node_source);
 }
 
@@ -336,7 +1629,7 @@ port_table_delete_phy__(struct port_table *tbl,
                         const char *bus_name, const char *dev_name,
                         uint32_t number, uint16_t flavour)
 {
-    struct port_node *phy;
+    struct phy_node *phy;
 
     phy = port_table_lookup_phy_bus_dev(tbl, bus_name, dev_name,
                                         flavour, number);
@@ -345,26 +1638,23 @@ port_table_delete_phy__(struct port_table *tbl,
                   bus_name, dev_name, number);
         return;
     }
-    hmap_remove(&tbl->ifindex_table, &phy->ifindex_node);
-    hmap_remove(&tbl->bus_dev_table, &phy->bus_dev_node);
-    port_node_destroy(phy);
+    port_table_detach_children(tbl, phy);
+    port_table_remove_phy(tbl, phy);
 }
 
 static void
-port_table_delete_function__(struct port_table *tbl, struct port_node *pf,
-                             uint16_t pci_vf_number)
+port_table_delete_function__(struct port_table *tbl, struct phy_node *pf,
+                             uint16_t flavour, uint32_t number)
 {
     struct port_node *pn;
 
-    pn = port_table_lookup_pf_mac_vf(tbl, pf->mac, pci_vf_number);
+    pn = port_table_lookup_function(tbl, pf, flavour, number);
     if (!pn) {
-        VLOG_WARN("attempt to remove non-existing function %s-%d",
-                  pf->netdev_name, pci_vf_number);
+        VLOG_WARN("attempt to remove non-existing function %s-%"PRIu32,
+                  pf->up.netdev_name, number);
         return;
     }
-    hmap_remove(&tbl->ifindex_table, &pn->ifindex_node);
-    hmap_remove(&tbl->mac_vf_table, &pn->mac_vf_node);
-    port_node_destroy(pn);
+    port_table_remove_function(tbl, function_node_cast(pn));
 }
 
 static void
@@ -380,37 +1670,241 @@ port_table_delete_entry(struct port_table *tbl,
             flavour == DEVLINK_PORT_FLAVOUR_PHYSICAL ? number : pci_pf_number,
             flavour);
     } else {
-        struct port_node *phy;
+        uint32_t fn_number = flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+                             ? number : pci_vf_number;
+        struct phy_node *phy;
 
         phy = port_table_lookup_phy_bus_dev(tbl, bus_name, dev_name,
                                             DEVLINK_PORT_FLAVOUR_PCI_PF,
                                             pci_pf_number);
         if (!phy) {
+            if (port_table_remove_pending(tbl, bus_name, dev_name,
+                                          pci_pf_number, flavour,
+                                          fn_number)) {
+                return;
+            }
             VLOG_WARN("attempt to remove function with non-existing PF "
                       "bus_dev %s/%s pci_pf_number %d",
                       bus_name, dev_name, pci_pf_number);
             return;
         }
-        port_table_delete_function__(tbl, phy, pci_vf_number);
+        port_table_delete_function__(tbl, phy, flavour, fn_number);
     }
 }
 
 static struct nl_sock *devlink_monitor_sock;
 
-#ifdef HAVE_UDEV
+#ifdef RENAME_TRACKING_UDEV
 static struct udev *udev;
 static struct udev_monitor *udev_monitor;
-#endif /* HAVE_UDEV */
+#endif /* RENAME_TRACKING_UDEV */
+
+#ifdef RENAME_TRACKING_RTNL
+static struct nln *rtnl_monitor_nln;
+static struct nln_notifier *rtnl_monitor_notifier;
+static struct rtnetlink_change rtnl_monitor_change;
+static bool rtnl_monitor_changed;
+#endif /* RENAME_TRACKING_RTNL */
 
 static bool compat_get_host_pf_mac(const char *, struct eth_addr *);
 
+/* sysfs attributes do not generate inotify events when the kernel changes
+ * their value, so the host PF MAC cache is refreshed by reading the file again
+ * at this interval, see port_table_compat_run. */
+#define COMPAT_PF_MAC_POLL_MSEC 10000
+
+#define COMPAT_PF_CONFIG_FMT "/sys/class/net/%s/smart_nic/pf/config"
+
+static void
+phy_node_compat_invalidate(struct phy_node *phy)
+{
+    phy->compat_pf_mac_valid = false;
+    phy->compat_pf_mac_next = LLONG_MAX;
+}
+
+/* Retrieves the host facing PF MAC address through the sysfs compatibility
+ * interface relative to the PHYSICAL port 'phy'.
+ *
+ * The result is cached in 'phy' and only read again after the netdev is
+ * renamed, removed or re-added.  port_table_compat_run keeps the cache up to
+ * date in the meantime. */
+static bool
+phy_node_get_host_pf_mac(struct phy_node *phy, struct eth_addr *ea)
+{
+    if (phy->compat_pf_mac_valid) {
+        *ea = phy->compat_pf_mac;
+        return true;
+    }
+    if (!compat_get_host_pf_mac(phy->up.netdev_name, ea)) {
+        return false;
+    }
+    phy->compat_pf_mac = *ea;
+    phy->compat_pf_mac_valid = true;
+    phy->compat_pf_mac_next = time_msec() + COMPAT_PF_MAC_POLL_MSEC;
+    return true;
+}
+
+/* Reads the host PF MAC of each PHYSICAL port in 'tbl' whose cache is due
+ * for a refresh at 'now' again, and re-indexes the functions of the PF that
+ * got its MAC from there when it changed.
+ *
+ * Returns true if the MAC of a PF changed. */
+static bool
+port_table_compat_run(struct port_table *tbl, long long int now)
+{
+    struct phy_node *phy;
+    bool changed = false;
+
+    CMAP_FOR_EACH (phy, bus_dev_node, &tbl->bus_dev_table) {
+        struct phy_node *pf;
+        struct eth_addr mac;
+
+        if (!phy->compat_pf_mac_valid) {
+            continue;
+        } else if (now < phy->compat_pf_mac_next) {
+            poll_timer_wait_until(phy->compat_pf_mac_next);
+            continue;
+        }
+
+        phy->compat_pf_mac_next = now + COMPAT_PF_MAC_POLL_MSEC;
+        poll_timer_wait_until(phy->compat_pf_mac_next);
+        if (!compat_get_host_pf_mac(phy->up.netdev_name, &mac)) {
+            /* The PF keeps its MAC, the next update of the PF retries. */
+            phy_node_compat_invalidate(phy);
+            continue;
+        } else if (eth_addr_equals(mac, phy->compat_pf_mac)) {
+            continue;
+        }
+
+        pf = port_table_lookup_phy_bus_dev(tbl, phy->bus_name, phy->dev_name,
+                                           DEVLINK_PORT_FLAVOUR_PCI_PF,
+                                           phy->up.number);
+        if (pf && eth_addr_equals(pf->up.mac, phy->compat_pf_mac)) {
+            port_table_update_pf_mac(tbl, pf, mac);
+            changed = true;
+        }
+        phy->compat_pf_mac = mac;
+    }
+    return changed;
+}
+
+/* Parses a PCI address in the "[domain:]bus:device.function" format. */
+static bool
+pci_bdf_from_string(const char *s, uint32_t *bdf)
+{
+    unsigned int domain, bus, device, function;
+    int n = 0;
+
+    if (!ovs_scan(s, "%x:%x:%x.%x%n", &domain, &bus, &device, &function,
+                  &n)) {
+        domain = 0;
+        if (!ovs_scan(s, "%x:%x.%x%n", &bus, &device, &function, &n)) {
+            return false;
+        }
+    }
+    if (s[n] || domain > 0xffff || bus > 0xff || device > 0x1f
+        || function > 0x7) {
+        return false;
+    }
+    *bdf = domain << 16 | bus << 8 | device << 3 | function;
+    return true;
+}
+
+static ssize_t sysfs_read(const char *file_name, char *buf, size_t size);
+
+/* Reads an unsigned decimal integer from the sysfs file 'file_name'. */
+static bool
+sysfs_read_uint(const char *file_name, unsigned int *value)
+{
+    char buf[32];
+    ssize_t n;
+
+    n = sysfs_read(file_name, buf, sizeof buf);
+    if (n <= 0) {
+        return false;
+    }
+    /* sysfs attributes are terminated by a newline. */
+    while (n > 0 && isspace((unsigned char) buf[n - 1])) {
+        buf[--n] = '\0';
+    }
+    return str_to_uint(buf, 10, value);
+}
+
+/* Retrieves the offset of the first VF and the distance between VFs from
+ * the SR-IOV capability of the PF at PCI address 'pf_bdf'. */
+static bool
+sysfs_get_sriov_layout(uint32_t pf_bdf, uint16_t *offset, uint16_t *stride)
+{
+    unsigned int sriov_offset, sriov_stride;
+    char file_name[64];
+
+#define SYSFS_PCI_FMT "/sys/bus/pci/devices/%04x:%02x:%02x.%x/%s"
+#define SYSFS_PCI_ARGS(BDF) (BDF) >> 16, ((BDF) >> 8) & 0xff, \
+                            ((BDF) >> 3) & 0x1f, (BDF) & 0x7
+    snprintf(file_name, sizeof file_name, SYSFS_PCI_FMT,
+             SYSFS_PCI_ARGS(pf_bdf), "sriov_offset");
+    if (!sysfs_read_uint(file_name, &sriov_offset)) {
+        return false;
+    }
+    snprintf(file_name, sizeof file_name, SYSFS_PCI_FMT,
+             SYSFS_PCI_ARGS(pf_bdf), "sriov_stride");
+    if (!sysfs_read_uint(file_name, &sriov_stride)) {
+        return false;
+    }
+    if (sriov_offset > UINT16_MAX || sriov_stride > UINT16_MAX) {
+        return false;
+    }
+    *offset = sriov_offset;
+    *stride = sriov_stride;
+    return true;
+}
+
+/* Derives the host PCI addresses of the VFs of PF 'pf' from the SR-IOV
+ * capability of the PF, and indexes the VFs by them.
+ *
+ * This is only possible when the PF is a local PCI device, i.e. on a
+ * hypervisor with a NIC in switchdev mode.  The PF then belongs to the
+ * devlink instance, and its address is that of the instance with the PF
+ * number as function.  On a SmartNIC DPU the PF is 'external', and the
+ * SR-IOV capability of the host's PF is not visible to us. */
+static void
+port_table_probe_pf_sriov(struct port_table *tbl, struct phy_node *pf,
+                          bool external)
+{
+    uint16_t offset, stride;
+    struct function_node *fn;
+    uint32_t pf_bdf;
+
+    if (pf->sriov_probed) {
+        return;
+    }
+    if (external || strcmp(pf->bus_name, "pci")
+        || !pci_bdf_from_string(pf->dev_name, &pf_bdf)) {
+        pf->sriov_probed = true;
+        return;
+    }
+    pf_bdf = (pf_bdf & ~0x7) + pf->up.number;
+    if (!sysfs_get_sriov_layout(pf_bdf, &offset, &stride)) {
+        /* Retried on the next update of the PF, the attributes may not be
+         * there yet while the PF is being set up. */
+        return;
+    }
+    pf->sriov_probed = true;
+    pf->vf_bdf_base = pf_bdf + offset;
+    pf->vf_bdf_stride = stride;
+    LIST_FOR_EACH (fn, pf_node, &pf->children) {
+        port_table_index_function_bdf(tbl, fn);
+    }
+}
+
 static void
 port_table_update_devlink_port(struct dl_port *port_entry,
                                enum port_node_source port_node_source)
 {
     if (port_entry->flavour != DEVLINK_PORT_FLAVOUR_PHYSICAL
             && port_entry->flavour != DEVLINK_PORT_FLAVOUR_PCI_PF
-            && port_entry->flavour != DEVLINK_PORT_FLAVOUR_PCI_VF) {
+            && port_entry->flavour != DEVLINK_PORT_FLAVOUR_PCI_VF
+            && port_entry->flavour != DEVLINK_PORT_FLAVOUR_PCI_SF) {
         VLOG_WARN("Unsupported flavour for port '%s': %s",
             port_entry->netdev_name,
             port_entry->flavour == DEVLINK_PORT_FLAVOUR_CPU ? "CPU" :
@@ -419,7 +1913,6 @@ port_table_update_devlink_port(struct dl_port *port_entry,
             port_entry->flavour == DEVLINK_PORT_FLAVOUR_PCI_VF ? "PCI_VF":
             port_entry->flavour == DEVLINK_PORT_FLAVOUR_VIRTUAL ? "VIRTUAL":
             port_entry->flavour == DEVLINK_PORT_FLAVOUR_UNUSED ? "UNUSED":
-            port_entry->flavour == DEVLINK_PORT_FLAVOUR_PCI_SF ? "PCI_SF":
             "UNKNOWN");
         return;
     };
@@ -441,7 +1934,7 @@ port_table_update_devlink_port(struct dl_port *port_entry,
          *
          * Attempt to retrieve host facing MAC address from the compatibility
          * interface */
-        struct port_node *phy;
+        struct phy_node *phy;
         phy = port_table_lookup_phy_bus_dev(port_table,
                                             port_entry->bus_name,
                                             port_entry->dev_name,
@@ -452,575 +1945,4967 @@ port_table_update_devlink_port(struct dl_port *port_entry,
                       "lookup of host PF MAC address.");
             return;
         }
-        if (!compat_get_host_pf_mac(phy->netdev_name, &fallback_mac)) {
+        if (!phy_node_get_host_pf_mac(phy, &fallback_mac)) {
             VLOG_WARN("Fallback lookup of host PF MAC address failed.");
             return;
         }
     }
-    port_table_update_entry(
+    struct port_node *pn = port_table_update_entry(
         port_table, port_entry->bus_name, port_entry->dev_name,
         port_entry->netdev_ifindex, port_entry->netdev_name,
-        port_entry->number, port_entry->pci_pf_number,
-        port_entry->pci_vf_number, port_entry->flavour,
+        port_entry->flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+            ? port_entry->pci_sf_number : port_entry->number,
+        port_entry->pci_pf_number, port_entry->pci_vf_number,
+        port_entry->flavour,
         port_entry->flavour == DEVLINK_PORT_FLAVOUR_PCI_PF
             && eth_addr_is_zero(port_entry->function.eth_addr) ?
         fallback_mac : port_entry->function.eth_addr,
         port_node_source);
+    if (!pn) {
+        return;
+    }
+    pn->dl_port_index = port_entry->index;
+    if (port_entry->flavour == DEVLINK_PORT_FLAVOUR_PCI_PF) {
+        struct phy_node *pf = phy_node_cast(pn);
+
+        pf->controller = port_entry->controller_number;
+        pf->external = port_entry->external == 1;
+        port_table_probe_pf_sriov(port_table, pf, pf->external);
+    }
 }
 
+static int devlink_port_function_set(const char *bus_name,
+                                     const char *dev_name,
+                                     uint32_t port_index,
+                                     const struct dl_port_function *);
+
+/* Identifies a function across a release of 'port_table_mutex', during
+ * which it may be changed or removed from the table. */
+struct port_ref {
+    uint32_t netdev_ifindex;
+    uint32_t dl_port_index;
+    char *bus_name;
+    char *dev_name;
+};
+
 static void
-port_table_delete_devlink_port(struct dl_port *port_entry)
+port_ref_init(struct port_ref *ref, const struct function_node *fn)
 {
-    port_table_delete_entry(port_table,
-                            port_entry->bus_name, port_entry->dev_name,
-                            port_entry->number, port_entry->pci_pf_number,
-                            port_entry->pci_vf_number, port_entry->flavour);
+    ref->netdev_ifindex = fn->up.netdev_ifindex;
+    ref->dl_port_index = fn->up.dl_port_index;
+    ref->bus_name = xstrdup(fn->pf->bus_name);
+    ref->dev_name = xstrdup(fn->pf->dev_name);
 }
 
-static int
-devlink_port_dump(void)
+static void
+port_ref_destroy(struct port_ref *ref)
 {
-    struct nl_dl_dump_state *port_dump;
-    struct dl_port port_entry;
-    int error;
+    free(ref->bus_name);
+    free(ref->dev_name);
+}
 
-    port_table = port_table_create();
+/* Returns the function 'ref' was taken from, or NULL if it is no longer in
+ * 'tbl'. */
+static struct function_node *
+port_ref_lookup(struct port_table *tbl, const struct port_ref *ref)
+{
+    struct port_node *pn = port_table_lookup_ifindex(tbl,
+                                                     ref->netdev_ifindex);
+    struct function_node *fn;
 
-    port_dump = nl_dl_dump_init();
-    if ((error = nl_dl_dump_init_error(port_dump))) {
-        VLOG_WARN(
-            "unable to start dump of ports from devlink-port interface");
-        return error;
-    }
-    nl_dl_dump_start(DEVLINK_CMD_PORT_GET, port_dump);
-    while (nl_dl_port_dump_next(port_dump, &port_entry)) {
-        port_table_update_devlink_port(&port_entry, PORT_NODE_SOURCE_DUMP);
+    if (!pn || port_node_is_phy(pn)
+        || pn->dl_port_index != ref->dl_port_index) {
+        return NULL;
     }
-    nl_dl_dump_finish(port_dump);
-    nl_dl_dump_destroy(port_dump);
-
-    return 0;
+    fn = function_node_cast(pn);
+    return (!strcmp(fn->pf->bus_name, ref->bus_name)
+            && !strcmp(fn->pf->dev_name, ref->dev_name)) ? fn : NULL;
 }
 
+/* Programs 'mac' as the host facing MAC of the function represented by
+ * '*pnp' through devlink, unless it is already in place.  The table is
+ * updated right away rather than waiting for the kernel to notify us, so
+ * that lookups by function MAC find the port immediately.
+ *
+ * 'port_table_mutex' is released for the duration of the devlink
+ * transaction, so that the monitor thread is not held up by it.  '*pnp' is
+ * then updated to the port as found again afterwards, or NULL if it was
+ * removed in the meantime.
+ *
+ * Returns 0 if successful or if nothing had to be done, EAGAIN if the
+ * devlink port index of the port is not known yet, ENODEV if it was
+ * removed, otherwise a positive errno value. */
 static int
-devlink_monitor_init(void)
+port_table_set_function_mac(struct port_table *tbl, struct port_node **pnp,
+                            struct eth_addr mac)
+    OVS_REQUIRES(port_table_mutex)
 {
-    unsigned int devlink_mcgroup;
+    struct dl_port_function port_fn = {
+        .eth_addr = mac,
+        .state = UINT8_MAX,
+        .opstate = UINT8_MAX,
+    };
+    struct port_node *pn = *pnp;
+    struct function_node *fn;
+    struct port_ref ref;
     int error;
 
-    error = nl_lookup_genl_mcgroup(DEVLINK_GENL_NAME,
-                                   DEVLINK_GENL_MCGRP_CONFIG_NAME,
-                                   &devlink_mcgroup);
+    if (port_node_is_phy(pn)) {
+        return EINVAL;
+    }
+    if (eth_addr_equals(pn->mac, mac)) {
+        return 0;
+    }
+    if (pn->dl_port_index == UINT32_MAX) {
+        return EAGAIN;
+    }
+
+    port_ref_init(&ref, function_node_cast(pn));
+    ovs_mutex_unlock(&port_table_mutex);
+    error = devlink_port_function_set(ref.bus_name, ref.dev_name,
+                                      ref.dl_port_index, &port_fn);
+    ovs_mutex_lock(&port_table_mutex);
+    fn = port_ref_lookup(tbl, &ref);
+    port_ref_destroy(&ref);
+
+    *pnp = fn ? &fn->up : NULL;
     if (error) {
         return error;
+    } else if (!fn) {
+        return ENODEV;
     }
+    port_table_update_function_mac(tbl, fn, mac);
+    return 0;
+}
 
-    error = nl_sock_create(NETLINK_GENERIC, &devlink_monitor_sock);
+static int devlink_port_new(const char *bus_name, const char *dev_name,
+                            uint16_t pci_pf_number, uint32_t pci_sf_number,
+                            uint32_t controller_number, struct dl_port *,
+                            struct ofpbuf **bufp);
+static int devlink_port_del(const char *bus_name, const char *dev_name,
+                            uint32_t port_index);
+
+/* Creates SF number 'sf_num' on PF 'pci_pf_number' of controller
+ * 'controller' of the devlink device 'bus_name'/'dev_name', programs 'mac'
+ * as its host facing MAC unless it is all zero, and activates it.  Does not
+ * touch the port table, so that it can be called without holding
+ * 'port_table_mutex'.
+ *
+ * On success returns 0 and stores the reply to the creation in
+ * '*port_entry', which refers to '*bufp' that the caller must free.
+ * Otherwise returns a positive errno value, and the SF is deleted again if
+ * it was created. */
+static int
+sf_create(const char *bus_name, const char *dev_name, uint16_t pci_pf_number,
+          uint32_t controller, uint32_t sf_num, struct eth_addr mac,
+          struct dl_port *port_entry, struct ofpbuf **bufp)
+{
+    struct dl_port_function port_fn = {
+        .eth_addr = mac,
+        .state = DEVLINK_PORT_FN_STATE_ACTIVE,
+        .opstate = UINT8_MAX,
+    };
+    int error;
+
+    error = devlink_port_new(bus_name, dev_name, pci_pf_number, sf_num,
+                             controller, port_entry, bufp);
     if (error) {
         return error;
     }
 
-    error = nl_sock_join_mcgroup(devlink_monitor_sock, devlink_mcgroup);
+    error = devlink_port_function_set(bus_name, dev_name, port_entry->index,
+                                      &port_fn);
     if (error) {
+        VLOG_WARN("unable to activate SF %"PRIu32" of %s/%s PF %"PRIu16", "
+                  "deleting it: %s", sf_num, bus_name, dev_name,
+                  pci_pf_number, ovs_strerror(error));
+        devlink_port_del(bus_name, dev_name, port_entry->index);
+        ofpbuf_delete(*bufp);
+        *bufp = NULL;
         return error;
     }
-
+    VLOG_INFO("created SF %"PRIu32" of %s/%s PF %"PRIu16" with devlink port "
+              "index %"PRIu32, sf_num, bus_name, dev_name, pci_pf_number,
+              port_entry->index);
     return 0;
 }
 
-static bool
-devlink_monitor_run(void)
+/* Deletes the SF represented by 'pn'.  The representor is removed from the
+ * table once the kernel notifies us of the deletion. */
+static int
+port_node_delete_sf(struct port_node *pn)
 {
-    uint64_t buf_stub[4096 / 64];
-    struct ofpbuf buf;
-    int error;
-    bool changed = false;
-
-    ofpbuf_use_stub(&buf, buf_stub, sizeof buf_stub);
-    for (;;) {
-        error = nl_sock_recv(devlink_monitor_sock, &buf, NULL, false);
-        if (error == EAGAIN) {
-            /* Nothing to do. */
-            break;
-        } else if (error == ENOBUFS) {
-            VLOG_WARN("devlink monitor socket overflowed: %s",
-                      ovs_strerror(error));
-        } else if (error) {
-            VLOG_ERR("error on devlink monitor socket: %s",
-                     ovs_strerror(error));
-            break;
-        } else {
-            struct genlmsghdr *genl;
-            struct dl_port port_entry;
+    const struct phy_node *pf;
 
-            genl = nl_msg_genlmsghdr(&buf);
-            if (genl->cmd == DEVLINK_CMD_PORT_NEW
-                    || genl->cmd == DEVLINK_CMD_PORT_DEL) {
-                if (!nl_dl_parse_port_policy(&buf, &port_entry)) {
-                    VLOG_WARN("could not parse devlink port entry");
-                    continue;
-                }
-                if (genl->cmd == DEVLINK_CMD_PORT_NEW) {
-                    if (port_entry.netdev_ifindex == UINT32_MAX) {
-                        /* When ports are removed we receive both a NEW CMD
-                         * without data, followed by a DEL CMD. Ignore the
-                         * empty NEW CMD */
-                        continue;
-                    }
-                    changed = true;
-                    port_table_update_devlink_port(&port_entry,
-                                                   PORT_NODE_SOURCE_RUNTIME);
-                } else if (genl->cmd == DEVLINK_CMD_PORT_DEL) {
-                    port_table_delete_devlink_port(&port_entry);
-                }
-            }
-        }
+    if (pn->flavour != DEVLINK_PORT_FLAVOUR_PCI_SF) {
+        return EINVAL;
     }
-    return changed;
+    if (pn->dl_port_index == UINT32_MAX) {
+        return EAGAIN;
+    }
+    pf = function_node_cast(pn)->pf;
+    return devlink_port_del(pf->bus_name, pf->dev_name, pn->dl_port_index);
 }
 
-#ifdef HAVE_UDEV
+static int devlink_rate_get(const char *bus_name, const char *dev_name,
+                            uint32_t port_index, struct dl_rate *,
+                            struct ofpbuf **bufp);
+static int devlink_rate_set(const struct dl_rate *);
+static int devlink_rate_new(const struct dl_rate *);
+
+/* Queries the rate leaf of the function 'ref' refers to into 'rate', to
+ * learn what a previous run of the provider, or the administrator,
+ * configured.  A driver without rate support is treated as having no rates
+ * configured. */
 static void
-udev_monitor_init(void)
+port_rate_query(const struct port_ref *ref, struct port_rate *rate)
 {
-    udev = udev_new();
-    if (!udev) {
-        VLOG_ERR("unable to initialize udev context.");
-        return;
-    }
+    struct dl_rate rate_entry;
+    struct ofpbuf *buf;
 
-    udev_monitor = udev_monitor_new_from_netlink(udev, "kernel");
-    if (!udev_monitor) {
-        VLOG_ERR("unable to initialize udev monitor.");
+    memset(rate, 0, sizeof *rate);
+    if (devlink_rate_get(ref->bus_name, ref->dev_name, ref->dl_port_index,
+                         &rate_entry, &buf)) {
+        rate->parent = xstrdup("");
         return;
     }
-    if (udev_monitor_filter_add_match_subsystem_devtype(
-            udev_monitor, "net", NULL) < 0) {
-        VLOG_WARN("unable to initialize udev monitor filter.");
-    }
-    if (udev_monitor_enable_receiving(udev_monitor) < 0) {
-        VLOG_ERR("unable to initialize udev monitor.");
-        return;
+    if (rate_entry.tx_share != UINT64_MAX) {
+        rate->tx_share = rate_entry.tx_share;
     }
-    if (udev_monitor_set_receive_buffer_size(udev_monitor,
-                                             128 * 1024 * 1024) < 0) {
-        VLOG_ERR("unable to set udev receive buffer size.");
-        return;
+    if (rate_entry.tx_max != UINT64_MAX) {
+        rate->tx_max = rate_entry.tx_max;
     }
+    rate->parent = xstrdup(rate_entry.parent_node_name);
+    ofpbuf_delete(buf);
 }
-#endif /* HAVE_UDEV */
 
-static bool
-udev_monitor_run(void)
+/* Sends the attributes of 'tx_share', 'tx_max' and 'group' that differ from
+ * 'rate', the rates last applied to the rate leaf of the function 'ref'
+ * refers to, and updates 'rate' if successful.
+ *
+ * Returns 0 if successful, otherwise a positive errno value. */
+static int
+port_rate_apply(const struct port_ref *ref, struct port_rate *rate,
+                uint64_t tx_share, uint64_t tx_max, const char *group)
 {
-    bool changed = false;
-#ifdef HAVE_UDEV
-    int fd;
-    char buf[1];
-    size_t n_recv;
-    struct udev_device *dev;
-
-    fd = udev_monitor_get_fd(udev_monitor);
-
-    for (;;) {
-        n_recv = recv(fd, buf, 1, MSG_DONTWAIT | MSG_PEEK);
-        if (n_recv == -1) {
-            if (errno == EAGAIN) {
-                /* Nothing to do. */
-                break;
-            } else {
-                VLOG_ERR("error on udev monitor socket: %s",
-                         ovs_strerror(errno));
-            }
-        } else {
-            dev = udev_monitor_receive_device(udev_monitor);
-            if (!dev) {
-                /* Nothing to do. */
-                break;
-            }
-            const char *udev_action = udev_device_get_action(dev);
-            if (udev_action && !strcmp(udev_action, "move")) {
-                const char *ifindex_str, *sysname;
-                char *cp = NULL;
-                uint32_t ifindex;
-                struct port_node *pn;
-
-                ifindex_str = udev_device_get_sysattr_value(dev, "ifindex");
-                if (!ifindex_str) {
-                    VLOG_WARN("udev: unable to get ifindex of moved netdev.");
-                    goto next;
-                }
-
-                sysname = udev_device_get_sysname(dev);
-                if (!sysname) {
-                    VLOG_ERR("Unable to lookup netdev name from udev.");
-                    goto next;
-                }
+    bool group_changed = strcmp(group, rate->parent);
+    struct dl_rate dl_rate;
+    int error;
 
-                ifindex = strtol(ifindex_str, &cp, 10);
-                if (cp && cp != ifindex_str && *cp != '\0') {
-                    VLOG_WARN("udev provided malformed ifindex: '%s'",
-                              ifindex_str);
-                    goto next;
-                }
+    if (group_changed && group[0]) {
+        dl_rate = (struct dl_rate) {
+            .bus_name = ref->bus_name,
+            .dev_name = ref->dev_name,
+            .type = DEVLINK_RATE_TYPE_NODE,
+            .port_index = UINT32_MAX,
+            .node_name = group,
+            .tx_share = UINT64_MAX,
+            .tx_max = UINT64_MAX,
+        };
+        error = devlink_rate_new(&dl_rate);
+        if (error && error != EEXIST) {
+            return error;
+        }
+    }
 
-                pn = port_table_lookup_ifindex(port_table, ifindex);
-                if (!pn) {
-                    VLOG_DBG("udev move event on port we do not know about "
-                             "ifindex=%s", ifindex_str);
-                    goto next;
-                }
+    dl_rate = (struct dl_rate) {
+        .bus_name = ref->bus_name,
+        .dev_name = ref->dev_name,
+        .type = DEVLINK_RATE_TYPE_LEAF,
+        .port_index = ref->dl_port_index,
+        .tx_share = tx_share != rate->tx_share ? tx_share : UINT64_MAX,
+        .tx_max = tx_max != rate->tx_max ? tx_max : UINT64_MAX,
+        .parent_node_name = group_changed ? group : NULL,
+    };
+    error = devlink_rate_set(&dl_rate);
+    if (error) {
+        return error;
+    }
 
-                port_node_update(pn, sysname);
-                changed = true;
-            }
-next:
-            udev_device_unref(dev);
-        }
+    rate->tx_share = tx_share;
+    rate->tx_max = tx_max;
+    if (group_changed) {
+        free(rate->parent);
+        rate->parent = xstrdup(group);
     }
-#endif /* HAVE_UDEV */
-    return changed;
+    return 0;
 }
 
+/* Applies the rates 'tx_share' and 'tx_max', in bytes per second with 0
+ * meaning no limit, and the rate group 'group', empty for none, to the
+ * devlink rate leaf of the function represented by '*pnp'.  The group is
+ * created if it does not exist.  Only attributes that differ from the ones
+ * last applied are sent, so plugging a port without QoS costs a single query
+ * of its rate leaf.
+ *
+ * Like port_table_set_function_mac, releases 'port_table_mutex' for the
+ * duration of the devlink transactions and updates '*pnp' to the port as
+ * found again afterwards, or NULL if it was removed in the meantime.
+ *
+ * Returns 0 if successful, EAGAIN if the devlink port index of the port is
+ * not known yet, ENODEV if it was removed, otherwise a positive errno
+ * value. */
 static int
-vif_plug_representor_init(void)
+port_table_set_rate(struct port_table *tbl, struct port_node **pnp,
+                    uint64_t tx_share, uint64_t tx_max, const char *group)
+    OVS_REQUIRES(port_table_mutex)
 {
+    struct port_node *pn = *pnp;
+    struct function_node *fn;
+    struct port_rate rate;
+    struct port_ref ref;
+    bool known;
     int error;
 
-    error = devlink_monitor_init();
-    if (error) {
-        return error;
+    if (port_node_is_phy(pn)) {
+        return EINVAL;
     }
-
-    error = devlink_port_dump();
-    if (error) {
-        return error;
+    fn = function_node_cast(pn);
+    if (!fn->rate) {
+        if (pn->dl_port_index == UINT32_MAX) {
+            return tx_share || tx_max || group[0] ? EAGAIN : 0;
+        }
+    } else if (tx_share == fn->rate->tx_share && tx_max == fn->rate->tx_max
+               && !strcmp(group, fn->rate->parent)) {
+        return 0;
     }
 
-#ifdef HAVE_UDEV
-    udev_monitor_init();
-#endif /* HAVE_UDEV */
-
-    return 0;
+    known = fn->rate != NULL;
+    if (known) {
+        rate = *fn->rate;
+        rate.parent = xstrdup(fn->rate->parent);
+    }
+    port_ref_init(&ref, fn);
+    ovs_mutex_unlock(&port_table_mutex);
+    if (!known) {
+        port_rate_query(&ref, &rate);
+    }
+    error = port_rate_apply(&ref, &rate, tx_share, tx_max, group);
+    ovs_mutex_lock(&port_table_mutex);
+    fn = port_ref_lookup(tbl, &ref);
+    port_ref_destroy(&ref);
+
+    *pnp = fn ? &fn->up : NULL;
+    if (!fn) {
+        free(rate.parent);
+        return error ? error : ENODEV;
+    }
+    if (!fn->rate) {
+        fn->rate = xmalloc(sizeof *fn->rate);
+    } else {
+        free(fn->rate->parent);
+    }
+    *fn->rate = rate;
+    return error;
 }
 
 static bool
-vif_plug_representor_run(struct vif_plug_class *plug_class OVS_UNUSED)
+port_node_is_idle_pool_sf(const struct port_node *pn)
 {
-    return devlink_monitor_run() & udev_monitor_run();
+    return pn->flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+           && pn->number >= SF_POOL_NUM_BASE
+           && eth_addr_is_zero(pn->mac);
 }
 
-static int
-vif_plug_representor_destroy(void)
+/* Returns an idle SF of PF 'pf' that is ready to be plugged, or NULL. */
+static struct port_node *
+phy_node_sf_pool_find_idle(const struct phy_node *pf)
 {
-    port_table_destroy(port_table);
+    struct function_node *fn;
 
-    return 0;
+    LIST_FOR_EACH (fn, pf_node, &pf->children) {
+        if (port_node_is_idle_pool_sf(&fn->up)
+            && fn->up.dl_port_index != UINT32_MAX
+            && !port_node_rename_expected(&fn->up)) {
+            return &fn->up;
+        }
+    }
+    return NULL;
 }
 
-static bool
-vif_plug_representor_port_prepare(const struct vif_plug_port_ctx_in *ctx_in,
-                                 struct vif_plug_port_ctx_out *ctx_out)
+/* Returns an SF number for the warm pool of PF 'pf' that is not in use. */
+static uint32_t
+port_table_sf_pool_next_num(struct port_table *tbl, struct phy_node *pf)
 {
-    if (ctx_in->op_type == PLUG_OP_REMOVE) {
-        return true;
-    }
-    const char *opt_pf_mac = smap_get(&ctx_in->lport_options,
-                                   "vif-plug:representor:pf-mac");
-    const char *opt_vf_num = smap_get(&ctx_in->lport_options,
-                                   "vif-plug:representor:vf-num");
-    if (!opt_pf_mac || !opt_vf_num) {
-         return false;
-    }
-
-    /* Ensure lookup tables are up to date */
-    vif_plug_representor_run(NULL);
-
-    struct eth_addr pf_mac;
-    if (!eth_addr_from_string(opt_pf_mac, &pf_mac)) {
-        VLOG_WARN("Unable to parse option as Ethernet address for lport: %s "
-                  "pf-mac: '%s' vf-num: '%s'",
-                  ctx_in->lport_name, opt_pf_mac, opt_vf_num);
-        return false;
-    }
-
-    char *cp = NULL;
-    uint16_t vf_num = strtol(opt_vf_num, &cp, 10);
-    if (cp && cp != opt_vf_num && *cp != '\0') {
-        VLOG_WARN("Unable to parse option as VF number for lport: %s "
-                  "pf-mac: '%s' vf-num: '%s'",
-                  ctx_in->lport_name, opt_pf_mac, opt_vf_num);
+    while (port_table_lookup_pf_mac_sf(tbl, pf->up.mac,
+                                       pf->sf_pool_next_num)
+           || phy_node_find_sf_request(pf, pf->sf_pool_next_num)) {
+        pf->sf_pool_next_num++;
     }
+    return pf->sf_pool_next_num++;
+}
 
+/* Stores in '*pnp' the SF of PF 'pf' claimed from the warm pool for the
+ * host facing MAC 'mac', claiming an idle one if that has not happened yet.
+ * Should the pool be empty, the creation of a new SF is requested instead,
+ * in which case '*pnp' is NULL until its representor is reported.
+ *
+ * Claiming an idle SF releases 'port_table_mutex', see
+ * port_table_set_function_mac, so 'pf' must not be used afterwards.
+ *
+ * Returns 0 if successful, otherwise a positive errno value. */
+static int
+port_table_sf_pool_claim(struct port_table *tbl, struct phy_node *pf,
+                         struct eth_addr mac, struct port_node **pnp)
+    OVS_REQUIRES(port_table_mutex)
+{
+    struct function_node *fn;
     struct port_node *pn;
-    pn = port_table_lookup_pf_mac_vf(port_table, pf_mac, vf_num);
+    int error;
 
-    if (!pn || !pn->netdev_name) {
-        VLOG_INFO("No representor port found for "
-                  "lport: %s pf-mac: '%s' vf-num: '%s'",
-                  ctx_in->lport_name, opt_pf_mac, opt_vf_num);
-        return false;
-    } else if (port_node_rename_expected(pn)) {
-        VLOG_INFO("Lookup of representor port successful, but we anticipate "
-                  "the netdev name to change, refusing plug/update of "
-                  "lport: %s current netdev_name: %s",
-                  ctx_in->lport_name, pn->netdev_name);
-        return false;
+    pn = port_table_lookup_function_mac(tbl, mac);
+    if (pn && pn->flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+        && function_node_cast(pn)->pf == pf) {
+        *pnp = pn;
+        return 0;
     }
 
-    if (ctx_out) {
-        ctx_out->name = pn->netdev_name;
-        ctx_out->type = NULL;
+    *pnp = NULL;
+    pn = phy_node_sf_pool_find_idle(pf);
+    if (!pn) {
+        if (!sf_provisioning) {
+            return ENOENT;
+        }
+        if (!phy_node_find_sf_request_mac(pf, mac)) {
+            VLOG_INFO("warm SF pool of PF %s is empty, creating SF on demand",
+                      pf->up.netdev_name);
+            phy_node_request_sf(pf, port_table_sf_pool_next_num(tbl, pf),
+                                mac);
+        }
+        return 0;
     }
-    return true;
-}
 
-static void
-vif_plug_representor_port_finish(
-        const struct vif_plug_port_ctx_in *ctx_in OVS_UNUSED,
-        struct vif_plug_port_ctx_out *ctx_out OVS_UNUSED)
-{
-    /* Nothing to be done here for now */
+    error = port_table_set_function_mac(tbl, &pn, mac);
+    if (error) {
+        return error;
+    }
+    fn = function_node_cast(pn);
+    fn->provisioned = true;
+    VLOG_INFO("claimed SF %s from the warm pool of PF %s",
+              pn->netdev_name, fn->pf->up.netdev_name);
+    /* Refill the pool from the next iteration of the main loop. */
+    sf_pool_next_run = 0;
+    poll_immediate_wake();
+    *pnp = pn;
+    return 0;
 }
 
+/* Creates or deletes idle SFs so that each PF has 'sf_pool_size' of them.
+ * SFs that are requested but whose representor was not reported yet count
+ * as idle, creation itself is left to port_table_sf_requests_run. */
 static void
-vif_plug_representor_port_ctx_destroy(
-        const struct vif_plug_port_ctx_in *ctx_in OVS_UNUSED,
-        struct vif_plug_port_ctx_out *ctx_out OVS_UNUSED)
+port_table_sf_pool_run(struct port_table *tbl, long long int now)
 {
-    /* Noting to be done here for now */
-}
+    struct phy_node *pf;
 
-const struct vif_plug_class vif_plug_representor = {
-    .type = "representor",
-    .init = vif_plug_representor_init,
-    .destroy = vif_plug_representor_destroy,
-    .vif_plug_get_maintained_iface_options = NULL, /* TODO */
-    .run = vif_plug_representor_run,
-    .vif_plug_port_prepare = vif_plug_representor_port_prepare,
-    .vif_plug_port_finish = vif_plug_representor_port_finish,
-    .vif_plug_port_ctx_destroy = vif_plug_representor_port_ctx_destroy,
+    if (!sf_provisioning) {
+        return;
+    }
+    if (now < sf_pool_next_run) {
+        poll_timer_wait_until(sf_pool_next_run);
+        return;
+    }
+    sf_pool_next_run = now + SF_POOL_RUN_INTERVAL_MSEC;
+
+    CMAP_FOR_EACH (pf, bus_dev_node, &tbl->bus_dev_table) {
+        struct function_node *fn;
+        struct sf_request *req;
+        size_t n_idle = 0;
+
+        if (pf->up.flavour != DEVLINK_PORT_FLAVOUR_PCI_PF) {
+            continue;
+        }
+        LIST_FOR_EACH (fn, pf_node, &pf->children) {
+            /* Surplus SFs are removed from the table once the kernel notifies
+             * us of their deletion. */
+            if (port_node_is_idle_pool_sf(&fn->up)
+                && ++n_idle > sf_pool_size) {
+                port_node_delete_sf(&fn->up);
+            }
+        }
+        LIST_FOR_EACH (req, list_node, &pf->sf_requests) {
+            if (eth_addr_is_zero(req->mac)) {
+                n_idle++;
+            }
+        }
+        for (; n_idle < sf_pool_size; n_idle++) {
+            phy_node_request_sf(pf, port_table_sf_pool_next_num(tbl, pf),
+                                eth_addr_zero);
+        }
+    }
+    poll_timer_wait_until(sf_pool_next_run);
+}
+
+/* Copy of an SF request being carried out, the PF may be removed from the
+ * table in the meantime. */
+struct sf_job {
+    char *bus_name;
+    char *dev_name;
+    uint16_t pci_pf_number;
+    uint32_t controller;
+    uint32_t sf_num;
+    struct eth_addr mac;
 };
 
-/* The kernel devlink-port interface provides a vendor neutral and standard way
- * of discovering host visible resources such as MAC address of interfaces from
- * a program running on the NIC SoC side.
- *
- * However a fairly recent kernel version is required for it to work, so until
- * this is widely available we provide this helper to retrieve the same
- * information from the interim sysfs solution. */
-#ifndef OVSTEST
+/* Picks the next queued SF request of 'tbl' into 'job', and gives up on
+ * created SFs whose representor failed to appear in time.  Returns false if
+ * there is no request to carry out. */
 static bool
-compat_get_host_pf_mac(const char *netdev_name, struct eth_addr *ea)
+port_table_sf_request_next(struct port_table *tbl, long long int now,
+                           struct sf_job *job)
 {
-    char file_name[IFNAMSIZ + 35 + 1];
-    FILE *stream;
-    char line[128];
-    bool retval = false;
+    struct phy_node *pf;
+
+    CMAP_FOR_EACH (pf, bus_dev_node, &tbl->bus_dev_table) {
+        struct sf_request *req;
+
+        LIST_FOR_EACH_SAFE (req, list_node, &pf->sf_requests) {
+            if (req->started == LLONG_MIN) {
+                req->started = now;
+                job->bus_name = xstrdup(pf->bus_name);
+                job->dev_name = xstrdup(pf->dev_name);
+                job->pci_pf_number = pf->up.number;
+                job->controller = pf->controller;
+                job->sf_num = req->sf_num;
+                job->mac = req->mac;
+                return true;
+            } else if (now >= req->started + SF_REQUEST_TIMEOUT_MSEC) {
+                VLOG_WARN("representor of SF %"PRIu32" of PF %s did not "
+                          "appear in time", req->sf_num, pf->up.netdev_name);
+                sf_request_destroy(req);
+            } else {
+                poll_timer_wait_until(req->started + SF_REQUEST_TIMEOUT_MSEC);
+            }
+        }
+    }
+    return false;
+}
 
-    snprintf(file_name, sizeof(file_name),
-             "/sys/class/net/%s/smart_nic/pf/config", netdev_name);
-    stream = fopen(file_name, "r");
-    if (!stream) {
-        VLOG_WARN("%s: open failed (%s)",
-                  file_name, ovs_strerror(errno));
-        *ea = eth_addr_zero;
+/* Records the outcome 'error' of carrying out 'job', whose reply is
+ * 'port_entry' on success.  Returns true if the representor of the SF was
+ * added to the table. */
+static bool
+port_table_sf_request_finish(struct port_table *tbl, const struct sf_job *job,
+                             int error, struct dl_port *port_entry)
+{
+    struct phy_node *pf;
+
+    pf = port_table_lookup_phy_bus_dev(tbl, job->bus_name, job->dev_name,
+                                       DEVLINK_PORT_FLAVOUR_PCI_PF,
+                                       job->pci_pf_number);
+    if (error) {
+        static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+        VLOG_WARN_RL(&rl, "unable to create SF %"PRIu32" of %s/%s PF "
+                     "%"PRIu16": %s", job->sf_num, job->bus_name,
+                     job->dev_name, job->pci_pf_number, ovs_strerror(error));
+        if (pf) {
+            phy_node_sf_request_done(pf, job->sf_num);
+        }
         return false;
     }
-    while (fgets(line, sizeof(line), stream)) {
-        char key[16];
-        char *cp;
-        if (ovs_scan(line, "%15[^:]: ", key)
-            && key[0] == 'M' && key[1] == 'A' && key[2] == 'C')
-        {
-            /* strip any newline character */
-            if ((cp = strchr(line, '\n')) != NULL) {
-                *cp = '\0';
-            }
-            /* point cp at end of key + ': ', i.e. start of MAC address */
-            cp = line + strnlen(key, sizeof(key)) + 2;
-            retval = eth_addr_from_string(cp, ea);
-            break;
+    if (!pf || port_entry->netdev_ifindex == UINT32_MAX) {
+        /* Left to the devlink notification. */
+        return false;
+    }
+    /* The reply describes the port as it was before we configured its
+     * function. */
+    if (!eth_addr_is_zero(job->mac)) {
+        port_entry->function.eth_addr = job->mac;
+    }
+    port_table_update_devlink_port(port_entry, PORT_NODE_SOURCE_RUNTIME);
+    return true;
+}
+
+static void
+port_table_delete_devlink_port(struct dl_port *port_entry)
+{
+    port_table_delete_entry(port_table,
+                            port_entry->bus_name, port_entry->dev_name,
+                            port_entry->flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+                                ? port_entry->pci_sf_number
+                                : port_entry->number,
+                            port_entry->pci_pf_number,
+                            port_entry->pci_vf_number, port_entry->flavour);
+}
+
+/* Warm restart snapshot of the port table.
+ *
+ * When ovn-controller is restarted the set of ports is most likely the same
+ * as before, so instead of having to wait for a full devlink dump before
+ * serving any lookups, we persist a compact binary snapshot of the table in
+ * the run directory.  As the run directory does not survive a reboot, neither
+ * does the snapshot, which means ifindexes stored in it are still meaningful.
+ *
+ * On startup the snapshot is mapped, validated cheaply against the kernel and
+ * loaded into the table, after which a devlink dump is run in the background
+ * to confirm it.  Ports that are not confirmed by the dump are removed once
+ * it completes.
+ *
+ * File layout, all integers in host byte order:
+ *
+ *     struct port_snapshot_header
+ *     struct port_snapshot_device  * header.n_devices
+ *     struct port_snapshot_port    * header.n_ports
+ *
+ * PHYSICAL and PF ports are stored before function ports, so that a PF is
+ * always present in the table by the time its functions are loaded.  Devlink
+ * bus and device names have no limit in the kernel, ports of devices whose
+ * names do not fit in a device record are left out of the snapshot and
+ * wait for the dump instead. */
+#define PORT_SNAPSHOT_MAGIC 0x50524f56 /* "VORP" */
+#define PORT_SNAPSHOT_VERSION 2
+#define PORT_SNAPSHOT_FILE "ovn-vif-representor.snapshot"
+
+/* Maximum number of function ports to check against the kernel when
+ * validating a snapshot.  All PHYSICAL and PF ports are always checked. */
+#define PORT_SNAPSHOT_N_SPOT_CHECKS 16
+
+struct port_snapshot_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_devices;
+    uint32_t n_ports;
+};
+
+struct port_snapshot_device {
+    char bus_name[16];
+    char dev_name[48];
+};
+
+struct port_snapshot_port {
+    uint32_t device_idx;
+    uint32_t netdev_ifindex;
+    uint32_t number;
+    uint16_t pci_pf_number;
+    uint16_t flavour;
+    struct eth_addr mac;
+    uint8_t pad[2];
+    char netdev_name[IFNAMSIZ];
+};
+
+static bool snapshot_check_ifindex(uint32_t netdev_ifindex,
+                                   const char *netdev_name);
+static bool snapshot_check_device(const char *bus_name,
+                                  const char *dev_name);
+
+static char *
+port_snapshot_file_name(void)
+{
+    return xasprintf("%s/%s", ovs_rundir(), PORT_SNAPSHOT_FILE);
+}
+
+/* Returns the index of the device record for the devlink device of 'phy',
+ * adding one if needed, or UINT32_MAX if its names do not fit in one. */
+static uint32_t
+port_snapshot_device_idx(struct shash *devices, const struct phy_node *phy,
+                         struct port_snapshot_device **dev_recs,
+                         size_t *n_dev_recs, size_t *allocated_dev_recs)
+{
+    struct shash_node *node;
+    char *key;
+
+    if (strlen(phy->bus_name) >= sizeof (*dev_recs)->bus_name
+        || strlen(phy->dev_name) >= sizeof (*dev_recs)->dev_name) {
+        static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+        VLOG_WARN_RL(&rl, "devlink device name %s/%s is too long for the "
+                     "port table snapshot, leaving its ports out",
+                     phy->bus_name, phy->dev_name);
+        return UINT32_MAX;
+    }
+
+    key = xasprintf("%s/%s", phy->bus_name, phy->dev_name);
+    node = shash_find(devices, key);
+    if (!node) {
+        struct port_snapshot_device *dev;
+
+        if (*n_dev_recs >= *allocated_dev_recs) {
+            *dev_recs = x2nrealloc(*dev_recs, allocated_dev_recs,
+                                   sizeof **dev_recs);
         }
+        dev = &(*dev_recs)[*n_dev_recs];
+        memset(dev, 0, sizeof *dev);
+        ovs_strzcpy(dev->bus_name, phy->bus_name, sizeof dev->bus_name);
+        ovs_strzcpy(dev->dev_name, phy->dev_name, sizeof dev->dev_name);
+        node = shash_add(devices, key, (void *) (uintptr_t) *n_dev_recs);
+        (*n_dev_recs)++;
     }
-    fclose(stream);
-    return retval;
+    free(key);
+    return (uintptr_t) node->data;
 }
-#endif /* OVSTEST */
 
-#ifdef OVSTEST
-#include "tests/ovstest.h"
+static void
+port_snapshot_fill_port(struct port_snapshot_port *rec,
+                        const struct port_node *pn, uint32_t device_idx)
+{
+    memset(rec, 0, sizeof *rec);
+    rec->device_idx = device_idx;
+    rec->netdev_ifindex = pn->netdev_ifindex;
+    rec->flavour = pn->flavour;
+    rec->mac = pn->mac;
+    rec->number = pn->number;
+    if (port_node_is_phy(pn)) {
+        rec->pci_pf_number = pn->flavour == DEVLINK_PORT_FLAVOUR_PCI_PF
+                             ? pn->number : UINT16_MAX;
+    } else {
+        rec->pci_pf_number = function_node_cast(pn)->pf->up.number;
+    }
+    ovs_strzcpy(rec->netdev_name, pn->netdev_name, sizeof rec->netdev_name);
+}
+
+/* Writes a snapshot of 'tbl' to 'file_name'.
+ *
+ * The snapshot is written to a temporary file which is renamed into place,
+ * so that a reader never observes a partially written snapshot. */
+static int
+port_snapshot_write(const struct port_table *tbl, const char *file_name)
+{
+    struct shash devices = SHASH_INITIALIZER(&devices);
+    struct port_snapshot_device *dev_recs = NULL;
+    size_t n_dev_recs = 0, allocated_dev_recs = 0;
+    struct port_snapshot_port *port_recs;
+    size_t n_port_recs = 0;
+    struct port_snapshot_header hdr;
+    struct function_node *fn;
+    struct phy_node *phy;
+    char *tmp_name;
+    int error = 0;
+    int fd;
+
+    port_recs = xcalloc(MAX(cmap_count(&tbl->ifindex_table), 1),
+                        sizeof *port_recs);
+
+    /* PHYSICAL and PF ports first. */
+    CMAP_FOR_EACH (phy, bus_dev_node, &tbl->bus_dev_table) {
+        uint32_t idx = port_snapshot_device_idx(&devices, phy, &dev_recs,
+                                                &n_dev_recs,
+                                                &allocated_dev_recs);
+        if (idx != UINT32_MAX) {
+            port_snapshot_fill_port(&port_recs[n_port_recs++], &phy->up,
+                                    idx);
+        }
+    }
+    CMAP_FOR_EACH (fn, mac_vf_node, &tbl->mac_vf_table) {
+        uint32_t idx = port_snapshot_device_idx(&devices, fn->pf, &dev_recs,
+                                                &n_dev_recs,
+                                                &allocated_dev_recs);
+        if (idx != UINT32_MAX) {
+            port_snapshot_fill_port(&port_recs[n_port_recs++], &fn->up,
+                                    idx);
+        }
+    }
+    shash_destroy(&devices);
+
+    hdr.magic = PORT_SNAPSHOT_MAGIC;
+    hdr.version = PORT_SNAPSHOT_VERSION;
+    hdr.n_devices = n_dev_recs;
+    hdr.n_ports = n_port_recs;
+
+    tmp_name = xasprintf("%s.tmp", file_name);
+    fd = open(tmp_name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        error = errno;
+        goto out;
+    }
+    if (write(fd, &hdr, sizeof hdr) != sizeof hdr
+        || (n_dev_recs && write(fd, dev_recs, n_dev_recs * sizeof *dev_recs)
+                          != n_dev_recs * sizeof *dev_recs)
+        || (n_port_recs
+            && write(fd, port_recs, n_port_recs * sizeof *port_recs)
+               != n_port_recs * sizeof *port_recs)) {
+        error = errno ? errno : EIO;
+        close(fd);
+        unlink(tmp_name);
+        goto out;
+    }
+    close(fd);
+    if (rename(tmp_name, file_name) < 0) {
+        error = errno;
+        unlink(tmp_name);
+    }
 
+out:
+    if (error) {
+        VLOG_WARN("%s: unable to write port table snapshot (%s)",
+                  file_name, ovs_strerror(error));
+    }
+    free(tmp_name);
+    free(port_recs);
+    free(dev_recs);
+    return error;
+}
+
+/* Validates the records of a snapshot.  Apart from structural integrity,
+ * the devlink devices, all PHYSICAL and PF ports and a sample of the
+ * function ports are checked against the kernel, the ports by looking up the
+ * name of their ifindex. */
 static bool
-compat_get_host_pf_mac(const char *netdev_name, struct eth_addr *ea)
+port_snapshot_validate(const struct port_snapshot_header *hdr,
+                       const struct port_snapshot_device *dev_recs,
+                       const struct port_snapshot_port *port_recs)
 {
+    size_t n_functions = 0, n_checked = 0;
+    size_t stride;
 
-    ovs_assert(!strcmp(netdev_name, "p0"));
-    *ea = (struct eth_addr)ETH_ADDR_C(00,53,00,00,00,51);
+    for (size_t i = 0; i < hdr->n_devices; i++) {
+        const struct port_snapshot_device *dev = &dev_recs[i];
+
+        if (!memchr(dev->bus_name, '\0', sizeof dev->bus_name)
+            || !memchr(dev->dev_name, '\0', sizeof dev->dev_name)) {
+            return false;
+        }
+        if (!snapshot_check_device(dev->bus_name, dev->dev_name)) {
+            VLOG_INFO("port table snapshot is stale, devlink device %s/%s "
+                      "is gone", dev->bus_name, dev->dev_name);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < hdr->n_ports; i++) {
+        const struct port_snapshot_port *rec = &port_recs[i];
+
+        if (rec->device_idx >= hdr->n_devices
+            || memchr(rec->netdev_name, '\0',
+                      sizeof rec->netdev_name) == NULL) {
+            return false;
+        }
+        if (rec->flavour != DEVLINK_PORT_FLAVOUR_PHYSICAL
+            && rec->flavour != DEVLINK_PORT_FLAVOUR_PCI_PF) {
+            n_functions++;
+        }
+    }
+
+    stride = MAX(n_functions / PORT_SNAPSHOT_N_SPOT_CHECKS, 1);
+    for (size_t i = 0, fn = 0; i < hdr->n_ports; i++) {
+        const struct port_snapshot_port *rec = &port_recs[i];
+        bool is_phy = rec->flavour == DEVLINK_PORT_FLAVOUR_PHYSICAL
+                      || rec->flavour == DEVLINK_PORT_FLAVOUR_PCI_PF;
+
+        if (!is_phy && fn++ % stride) {
+            continue;
+        }
+        if (!snapshot_check_ifindex(rec->netdev_ifindex, rec->netdev_name)) {
+            VLOG_INFO("port table snapshot is stale, ifindex %"PRIu32" is "
+                      "no longer %s", rec->netdev_ifindex, rec->netdev_name);
+            return false;
+        }
+        n_checked++;
+    }
+    VLOG_DBG("port table snapshot validated, %"PRIuSIZE" ports checked",
+             n_checked);
     return true;
 }
 
+/* Loads a previously written snapshot from 'file_name' into 'tbl'.
+ *
+ * Returns true if the snapshot was found to be valid and was loaded, false
+ * otherwise in which case 'tbl' is left unchanged. */
+static bool
+port_snapshot_load(struct port_table *tbl, const char *file_name)
+{
+    const struct port_snapshot_header *hdr;
+    const struct port_snapshot_device *dev_recs;
+    const struct port_snapshot_port *port_recs;
+    struct stat st;
+    bool loaded = false;
+    void *map;
+    int fd;
+
+    fd = open(file_name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            VLOG_WARN("%s: open failed (%s)", file_name, ovs_strerror(errno));
+        }
+        return false;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < sizeof *hdr) {
+        close(fd);
+        return false;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        VLOG_WARN("%s: mmap failed (%s)", file_name, ovs_strerror(errno));
+        return false;
+    }
+
+    hdr = map;
+    if (hdr->magic != PORT_SNAPSHOT_MAGIC
+        || hdr->version != PORT_SNAPSHOT_VERSION
+        || st.st_size != sizeof *hdr
+                         + (off_t) hdr->n_devices * sizeof *dev_recs
+                         + (off_t) hdr->n_ports * sizeof *port_recs) {
+        VLOG_INFO("%s: ignoring incompatible port table snapshot",
+                  file_name);
+        goto out;
+    }
+    dev_recs = ALIGNED_CAST(const struct port_snapshot_device *, hdr + 1);
+    port_recs = ALIGNED_CAST(const struct port_snapshot_port *,
+                             dev_recs + hdr->n_devices);
+    if (!port_snapshot_validate(hdr, dev_recs, port_recs)) {
+        goto out;
+    }
+
+    for (size_t i = 0; i < hdr->n_ports; i++) {
+        const struct port_snapshot_port *rec = &port_recs[i];
+        const struct port_snapshot_device *dev = &dev_recs[rec->device_idx];
+        bool is_phy = rec->flavour == DEVLINK_PORT_FLAVOUR_PHYSICAL
+                      || rec->flavour == DEVLINK_PORT_FLAVOUR_PCI_PF;
+
+        port_table_update_entry(
+            tbl, dev->bus_name, dev->dev_name, rec->netdev_ifindex,
+            rec->netdev_name,
+            rec->flavour == DEVLINK_PORT_FLAVOUR_PHYSICAL
+            || rec->flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+                ? rec->number : UINT32_MAX,
+            rec->pci_pf_number, is_phy ? UINT16_MAX : rec->number,
+            rec->flavour, rec->mac, PORT_NODE_SOURCE_SNAPSHOT);
+    }
+    VLOG_INFO("%s: restored %"PRIu32" ports from port table snapshot",
+              file_name, hdr->n_ports);
+    loaded = true;
+
+out:
+    munmap(map, st.st_size);
+    return loaded;
+}
+
+/* Removes ports restored from snapshot that were not confirmed by a
+ * subsequent devlink dump. */
 static void
-_init_store(void)
+port_table_sweep_snapshot(struct port_table *tbl)
+{
+    struct function_node *fn;
+    struct phy_node *phy;
+
+    /* Functions first, so that we never leave a function referring to a
+     * removed PF. */
+    CMAP_FOR_EACH (fn, mac_vf_node, &tbl->mac_vf_table) {
+        if (fn->up.port_node_source == PORT_NODE_SOURCE_SNAPSHOT) {
+            VLOG_DBG("removing unconfirmed snapshot port %s",
+                     fn->up.netdev_name);
+            port_table_remove_function(tbl, fn);
+        }
+    }
+    CMAP_FOR_EACH (phy, bus_dev_node, &tbl->bus_dev_table) {
+        if (phy->up.port_node_source == PORT_NODE_SOURCE_SNAPSHOT) {
+            VLOG_DBG("removing unconfirmed snapshot port %s",
+                     phy->up.netdev_name);
+            port_table_detach_children(tbl, phy);
+            port_table_remove_phy(tbl, phy);
+        }
+    }
+
+    struct pending_pf *ppf;
+    HMAP_FOR_EACH_SAFE (ppf, hmap_node, &tbl->pending_table) {
+        struct pending_function *pfn;
+
+        LIST_FOR_EACH_SAFE (pfn, list_node, &ppf->functions) {
+            if (pfn->port_node_source == PORT_NODE_SOURCE_SNAPSHOT) {
+                ovs_list_remove(&pfn->list_node);
+                pending_function_destroy(pfn);
+            }
+        }
+        if (ovs_list_is_empty(&ppf->functions)) {
+            pending_pf_destroy(tbl, ppf);
+        }
+    }
+}
+
+/* State of the initial dump of devlink ports.
+ *
+ * The dump is started from vif_plug_representor_init, but processed
+ * incrementally from vif_plug_representor_run so that ovn-controller is not
+ * held up by it.  On some devices retrieving information about each port
+ * involves a firmware round-trip, and there may be thousands of ports.  The
+ * dump is asynchronous, which means we never block waiting for the kernel to
+ * produce the next batch of replies either. */
+static struct nl_dl_async_dump *port_dump;
+static int port_dump_error;
+static bool port_table_ready;
+
+/* Set when the initial dump failed.  Replies may have been lost, so a
+ * resynchronization dump takes its place, retried every PORT_DUMP_RETRY_MSEC
+ * until one completes.  Until then the table is only ready if a snapshot was
+ * loaded. */
+static bool port_dump_failed;
+static long long int port_dump_retry;
+
+#define PORT_DUMP_RETRY_MSEC 1000
+
+static void
+devlink_port_dump_reply(struct dl_port *port_entry, void *aux OVS_UNUSED)
+{
+    port_table_update_devlink_port(port_entry, PORT_NODE_SOURCE_DUMP);
+}
+
+static void
+devlink_port_dump_done(int error, void *aux OVS_UNUSED)
+{
+    if (error) {
+        VLOG_WARN("dump of ports from devlink-port interface failed: %s",
+                  ovs_strerror(error));
+    }
+    port_dump_error = error;
+}
+
+static int
+devlink_port_dump_start(void)
 {
+    char *snapshot_file_name;
+    int error;
+
     port_table = port_table_create();
 
-    port_table_update_entry(
-        port_table, "pci", "0000:03:00.0", 10, "p0", 0,
-        UINT16_MAX, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PHYSICAL,
-        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,00),
+    /* Serve lookups from the snapshot of a previous run, if any, while the
+     * dump confirms it. */
+    snapshot_file_name = port_snapshot_file_name();
+    port_table_ready = port_snapshot_load(port_table, snapshot_file_name);
+    free(snapshot_file_name);
+
+    error = nl_dl_async_port_dump_start(devlink_port_dump_reply,
+                                        devlink_port_dump_done, NULL,
+                                        &port_dump);
+    if (error) {
+        VLOG_WARN(
+            "unable to start dump of ports from devlink-port interface");
+        return error;
+    }
+
+    return 0;
+}
+
+/* Makes 'tbl' ready to serve lookups once a dump of all ports completed
+ * without error. */
+static void
+port_table_dump_complete(struct port_table *tbl)
+{
+    char *snapshot_file_name = port_snapshot_file_name();
+
+    port_table_sweep_snapshot(tbl);
+    port_snapshot_write(tbl, snapshot_file_name);
+    free(snapshot_file_name);
+    port_table_ready = true;
+    VLOG_INFO("representor port table populated.");
+}
+
+/* Completes the initial dump.  Returns true if the port table became ready to
+ * serve lookups. */
+static bool
+devlink_port_dump_finish(void)
+{
+    if (port_dump_error) {
+        /* Start the resynchronization dump from the next run. */
+        port_dump_failed = true;
+        port_dump_retry = time_msec();
+        poll_immediate_wake();
+        return false;
+    }
+    port_table_dump_complete(port_table);
+    return true;
+}
+
+/* Processes replies from the in-flight devlink port dump until done,
+ * 'deadline' is reached or no more replies are ready.
+ *
+ * Returns true when the dump completed without error during this call, in
+ * which case the port table is ready to serve lookups.  When more replies
+ * are ready an
+ * immediate wake up of the poll loop is requested, otherwise a wake up when
+ * they are. */
+static bool
+devlink_port_dump_run(long long int deadline)
+{
+    if (!port_dump) {
+        return false;
+    }
+    for (size_t i = 0; !nl_dl_async_dump_is_done(port_dump); i++) {
+        if (run_budget_exhausted(deadline, i)) {
+            return false;
+        }
+        if (!nl_dl_async_dump_run(port_dump, 1)
+            && !nl_dl_async_dump_is_done(port_dump)) {
+            nl_dl_async_dump_wait(port_dump);
+            return false;
+        }
+    }
+    nl_dl_async_dump_destroy(port_dump);
+    port_dump = NULL;
+
+    return devlink_port_dump_finish();
+}
+
+/* State of the dump resynchronizing the port table after the devlink monitor
+ * socket overflowed.
+ *
+ * Notifications were lost, so all ports are dumped again, and the ports the
+ * dump does not report are removed once it completes.  Like the initial dump
+ * it is processed incrementally from the main loop within the run budget.
+ * The notifications queued before the dump started are superseded by it and
+ * discarded, those that arrive while it is in progress are left queued on
+ * the monitor socket to be applied on top of it. */
+static struct nl_dl_async_dump *port_resync;
+static int port_resync_error;
+
+/* Returns the node in 'tbl' for the devlink port 'port_entry', or NULL. */
+static struct port_node *
+port_table_lookup_devlink_port(struct port_table *tbl,
+                               const struct dl_port *port_entry)
+{
+    struct phy_node *phy;
+
+    if (port_entry->flavour == DEVLINK_PORT_FLAVOUR_PHYSICAL) {
+        phy = port_table_lookup_phy_bus_dev(tbl, port_entry->bus_name,
+                                            port_entry->dev_name,
+                                            port_entry->flavour,
+                                            port_entry->number);
+        return phy ? &phy->up : NULL;
+    }
+
+    phy = port_table_lookup_phy_bus_dev(tbl, port_entry->bus_name,
+                                        port_entry->dev_name,
+                                        DEVLINK_PORT_FLAVOUR_PCI_PF,
+                                        port_entry->pci_pf_number);
+    if (!phy) {
+        return NULL;
+    } else if (port_entry->flavour == DEVLINK_PORT_FLAVOUR_PCI_PF) {
+        return &phy->up;
+    } else if (port_entry->flavour == DEVLINK_PORT_FLAVOUR_PCI_VF) {
+        return port_table_lookup_pf_mac_vf(tbl, phy->up.mac,
+                                           port_entry->pci_vf_number);
+    } else if (port_entry->flavour == DEVLINK_PORT_FLAVOUR_PCI_SF) {
+        return port_table_lookup_pf_mac_sf(tbl, phy->up.mac,
+                                           port_entry->pci_sf_number);
+    }
+    return NULL;
+}
+
+static void
+port_resync_reply(struct dl_port *port_entry, void *aux OVS_UNUSED)
+{
+    struct port_node *pn;
+
+    /* A port without a netdev at the moment, for example while the netdev
+     * is moved to another network namespace, is kept as it is. */
+    if (port_entry->netdev_ifindex != UINT32_MAX) {
+        port_table_update_devlink_port(port_entry, PORT_NODE_SOURCE_DUMP);
+    }
+    pn = port_table_lookup_devlink_port(port_table, port_entry);
+    if (pn) {
+        pn->resync_stale = false;
+    }
+}
+
+static void
+port_resync_done(int error, void *aux OVS_UNUSED)
+{
+    if (error) {
+        VLOG_WARN("resynchronization dump of devlink ports failed: %s",
+                  ovs_strerror(error));
+    }
+    port_resync_error = error;
+}
+
+/* Marks all ports of 'tbl' as not reported by the resynchronization dump
+ * yet. */
+static void
+port_table_resync_mark(struct port_table *tbl)
+{
+    struct function_node *fn;
+    struct phy_node *phy;
+
+    CMAP_FOR_EACH (phy, bus_dev_node, &tbl->bus_dev_table) {
+        phy->up.resync_stale = true;
+    }
+    CMAP_FOR_EACH (fn, mac_vf_node, &tbl->mac_vf_table) {
+        fn->up.resync_stale = true;
+    }
+}
+
+/* Starts resynchronizing 'tbl' with the kernel, unless that is in progress
+ * already. */
+static void
+port_table_resync_start(struct port_table *tbl)
+{
+    int error;
+
+    if (port_resync) {
+        return;
+    }
+    nl_sock_drain(devlink_monitor_sock);
+    error = nl_dl_async_port_dump_start(port_resync_reply, port_resync_done,
+                                        NULL, &port_resync);
+    if (error) {
+        VLOG_WARN("unable to start resynchronization dump of devlink ports: "
+                  "%s", ovs_strerror(error));
+        port_resync = NULL;
+        return;
+    }
+    port_resync_error = 0;
+    port_table_resync_mark(tbl);
+}
+
+/* Removes the ports of 'tbl' that the completed resynchronization dump did
+ * not report. */
+static void
+port_table_sweep_resync(struct port_table *tbl)
+{
+    struct function_node *fn;
+    struct phy_node *phy;
+    size_t n_removed = 0;
+
+    /* Functions first, so that we never leave a function referring to a
+     * removed PF. */
+    CMAP_FOR_EACH (fn, mac_vf_node, &tbl->mac_vf_table) {
+        if (fn->up.resync_stale) {
+            VLOG_DBG("removing port %s gone while notifications were lost",
+                     fn->up.netdev_name);
+            port_table_remove_function(tbl, fn);
+            n_removed++;
+        }
+    }
+    CMAP_FOR_EACH (phy, bus_dev_node, &tbl->bus_dev_table) {
+        if (phy->up.resync_stale) {
+            VLOG_DBG("removing port %s gone while notifications were lost",
+                     phy->up.netdev_name);
+            port_table_detach_children(tbl, phy);
+            port_table_remove_phy(tbl, phy);
+            n_removed++;
+        }
+    }
+    VLOG_INFO("resynchronized devlink ports, %"PRIuSIZE" removed.",
+              n_removed);
+}
+
+/* Completes the resynchronization dump.  When it stands in for a failed
+ * initial dump, the table becomes ready if it succeeded, otherwise it is
+ * retried after PORT_DUMP_RETRY_MSEC.  Returns true. */
+static bool
+port_table_resync_finish(struct port_table *tbl)
+{
+    if (port_resync_error) {
+        if (port_dump_failed) {
+            port_dump_retry = time_msec() + PORT_DUMP_RETRY_MSEC;
+        }
+        return true;
+    }
+    port_table_sweep_resync(tbl);
+    if (port_dump_failed) {
+        port_dump_failed = false;
+        port_table_dump_complete(tbl);
+    }
+    return true;
+}
+
+/* Processes replies to the resynchronization dump until done, 'deadline' is
+ * reached or no more replies are ready, like devlink_port_dump_run.
+ *
+ * Returns true when the dump completed during this call. */
+static bool
+port_table_resync_run(struct port_table *tbl, long long int deadline)
+{
+    if (!port_resync) {
+        return false;
+    }
+    for (size_t i = 0; !nl_dl_async_dump_is_done(port_resync); i++) {
+        if (run_budget_exhausted(deadline, i)) {
+            return false;
+        }
+        if (!nl_dl_async_dump_run(port_resync, 1)
+            && !nl_dl_async_dump_is_done(port_resync)) {
+            nl_dl_async_dump_wait(port_resync);
+            return false;
+        }
+    }
+    nl_dl_async_dump_destroy(port_resync);
+    port_resync = NULL;
+
+    return port_table_resync_finish(tbl);
+}
+
+/* Restarts the resynchronization dump standing in for a failed initial dump,
+ * see 'port_dump_failed'. */
+static void
+port_table_dump_retry_run(struct port_table *tbl, long long int now)
+{
+    if (!port_dump_failed || port_resync) {
+        return;
+    }
+    if (now >= port_dump_retry) {
+        port_dump_retry = now + PORT_DUMP_RETRY_MSEC;
+        port_table_resync_start(tbl);
+    }
+    if (!port_resync) {
+        poll_timer_wait_until(port_dump_retry);
+    }
+}
+
+/* Attaches the classic BPF program 'code' to the socket 'fd', so that the
+ * kernel drops messages we are not interested in before they are queued to
+ * the socket.  This saves both wakeups and copying of data to user space.
+ *
+ * Failure to attach the filter is not fatal, as the monitor functions do
+ * their own filtering in user space regardless. */
+static void
+monitor_attach_filter(int fd, const struct sock_filter *code, size_t n_code,
+                      const char *monitor_name)
+{
+    struct sock_fprog fprog = {
+        .len = n_code,
+        .filter = CONST_CAST(struct sock_filter *, code),
+    };
+
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER,
+                   &fprog, sizeof fprog) < 0) {
+        VLOG_WARN("unable to attach socket filter to %s monitor: %s",
+                  monitor_name, ovs_strerror(errno));
+    }
+}
+
+/* Only pass DEVLINK_CMD_PORT_NEW and DEVLINK_CMD_PORT_DEL notifications.
+ *
+ * Multicast notifications are delivered as one message per packet, which
+ * means the generic netlink command is always at a fixed offset. */
+static const struct sock_filter devlink_monitor_filter[] = {
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS,
+             NLMSG_HDRLEN + offsetof(struct genlmsghdr, cmd)),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, DEVLINK_CMD_PORT_NEW, 1, 0),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, DEVLINK_CMD_PORT_DEL, 0, 1),
+    BPF_STMT(BPF_RET | BPF_K, UINT32_MAX),
+    BPF_STMT(BPF_RET | BPF_K, 0),
+};
+
+static void
+devlink_monitor_attach_filter(void)
+{
+    monitor_attach_filter(nl_sock_fd(devlink_monitor_sock),
+                          devlink_monitor_filter,
+                          ARRAY_SIZE(devlink_monitor_filter), "devlink");
+}
+
+static int
+devlink_monitor_init(void)
+{
+    unsigned int devlink_mcgroup;
+    int error;
+
+    error = nl_lookup_genl_mcgroup(DEVLINK_GENL_NAME,
+                                   DEVLINK_GENL_MCGRP_CONFIG_NAME,
+                                   &devlink_mcgroup);
+    if (error) {
+        return error;
+    }
+
+    error = nl_sock_create(NETLINK_GENERIC, &devlink_monitor_sock);
+    if (error) {
+        return error;
+    }
+
+    error = nl_sock_join_mcgroup(devlink_monitor_sock, devlink_mcgroup);
+    if (error) {
+        return error;
+    }
+    devlink_monitor_attach_filter();
+
+    return 0;
+}
+
+static bool
+devlink_monitor_run(long long int deadline)
+{
+    uint64_t buf_stub[4096 / 64];
+    struct ofpbuf buf;
+    int error;
+    bool changed = false;
+
+    if (port_resync) {
+        /* Applied once the resynchronization dump is complete. */
+        return false;
+    }
+
+    ofpbuf_use_stub(&buf, buf_stub, sizeof buf_stub);
+    for (size_t i = 0; !run_budget_exhausted(deadline, i); i++) {
+        error = nl_sock_recv(devlink_monitor_sock, &buf, NULL, false);
+        if (error == EAGAIN) {
+            /* Nothing to do. */
+            break;
+        } else if (error == ENOBUFS) {
+            VLOG_WARN("devlink monitor socket overflowed: %s, "
+                      "resynchronizing all ports", ovs_strerror(error));
+            port_table_resync_start(port_table);
+            changed = true;
+            break;
+        } else if (error) {
+            VLOG_ERR("error on devlink monitor socket: %s",
+                     ovs_strerror(error));
+            break;
+        } else {
+            struct genlmsghdr *genl;
+            struct dl_port port_entry;
+
+            genl = nl_msg_genlmsghdr(&buf);
+            if (genl->cmd == DEVLINK_CMD_PORT_NEW
+                    || genl->cmd == DEVLINK_CMD_PORT_DEL) {
+                if (!nl_dl_parse_port_policy(&buf, &port_entry)) {
+                    VLOG_WARN("could not parse devlink port entry");
+                    continue;
+                }
+                if (genl->cmd == DEVLINK_CMD_PORT_NEW) {
+                    if (port_entry.netdev_ifindex == UINT32_MAX) {
+                        /* When ports are removed we receive both a NEW CMD
+                         * without data, followed by a DEL CMD. Ignore the
+                         * empty NEW CMD */
+                        continue;
+                    }
+                    changed = true;
+                    port_table_update_devlink_port(&port_entry,
+                                                   PORT_NODE_SOURCE_RUNTIME);
+                } else if (genl->cmd == DEVLINK_CMD_PORT_DEL) {
+                    port_table_delete_devlink_port(&port_entry);
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+#ifdef RENAME_TRACKING_UDEV
+/* Only pass kernel uevents with the "move" action.
+ *
+ * Since we receive directly from the kernel uevent multicast group, messages
+ * are in the raw kernel format which starts with "ACTION@DEVPATH".  libudev
+ * does not install any filter of its own for this group.  Absolute loads
+ * are in network byte order, hence the order of the characters. */
+static const struct sock_filter udev_monitor_filter[] = {
+    BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 0),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+             ('m' << 24) | ('o' << 16) | ('v' << 8) | 'e', 0, 3),
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 4),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, '@', 0, 1),
+    BPF_STMT(BPF_RET | BPF_K, UINT32_MAX),
+    BPF_STMT(BPF_RET | BPF_K, 0),
+};
+
+static void
+udev_monitor_attach_filter(void)
+{
+    monitor_attach_filter(udev_monitor_get_fd(udev_monitor),
+                          udev_monitor_filter,
+                          ARRAY_SIZE(udev_monitor_filter), "udev");
+}
+
+static void
+udev_monitor_init(void)
+{
+    udev = udev_new();
+    if (!udev) {
+        VLOG_ERR("unable to initialize udev context.");
+        return;
+    }
+
+    udev_monitor = udev_monitor_new_from_netlink(udev, "kernel");
+    if (!udev_monitor) {
+        VLOG_ERR("unable to initialize udev monitor.");
+        return;
+    }
+    if (udev_monitor_filter_add_match_subsystem_devtype(
+            udev_monitor, "net", NULL) < 0) {
+        VLOG_WARN("unable to initialize udev monitor filter.");
+    }
+    if (udev_monitor_enable_receiving(udev_monitor) < 0) {
+        VLOG_ERR("unable to initialize udev monitor.");
+        return;
+    }
+    /* Must be attached after enabling the monitor, as libudev would
+     * otherwise detach it when updating its own filter configuration. */
+    udev_monitor_attach_filter();
+    if (udev_monitor_set_receive_buffer_size(udev_monitor,
+                                             128 * 1024 * 1024) < 0) {
+        VLOG_ERR("unable to set udev receive buffer size.");
+        return;
+    }
+}
+#endif /* RENAME_TRACKING_UDEV */
+
+static bool
+udev_monitor_run(long long int deadline OVS_UNUSED)
+{
+    bool changed = false;
+#ifdef RENAME_TRACKING_UDEV
+    int fd;
+    char buf[1];
+    size_t n_recv;
+    struct udev_device *dev;
+
+    fd = udev_monitor_get_fd(udev_monitor);
+
+    for (size_t i = 0; !run_budget_exhausted(deadline, i); i++) {
+        n_recv = recv(fd, buf, 1, MSG_DONTWAIT | MSG_PEEK);
+        if (n_recv == -1) {
+            if (errno == EAGAIN) {
+                /* Nothing to do. */
+                break;
+            } else {
+                VLOG_ERR("error on udev monitor socket: %s",
+                         ovs_strerror(errno));
+            }
+        } else {
+            dev = udev_monitor_receive_device(udev_monitor);
+            if (!dev) {
+                /* Nothing to do. */
+                break;
+            }
+            const char *udev_action = udev_device_get_action(dev);
+            if (udev_action && !strcmp(udev_action, "move")) {
+                const char *ifindex_str, *sysname;
+                char *cp = NULL;
+                uint32_t ifindex;
+                struct port_node *pn;
+
+                ifindex_str = udev_device_get_sysattr_value(dev, "ifindex");
+                if (!ifindex_str) {
+                    VLOG_WARN("udev: unable to get ifindex of moved netdev.");
+                    goto next;
+                }
+
+                sysname = udev_device_get_sysname(dev);
+                if (!sysname) {
+                    VLOG_ERR("Unable to lookup netdev name from udev.");
+                    goto next;
+                }
+
+                ifindex = strtol(ifindex_str, &cp, 10);
+                if (cp && cp != ifindex_str && *cp != '\0') {
+                    VLOG_WARN("udev provided malformed ifindex: '%s'",
+                              ifindex_str);
+                    goto next;
+                }
+
+                pn = port_table_lookup_ifindex(port_table, ifindex);
+                if (!pn) {
+                    VLOG_DBG("udev move event on port we do not know about "
+                             "ifindex=%s, buffering it", ifindex_str);
+                    rename_buffer_record(ifindex, sysname, true);
+                    goto next;
+                }
+
+                port_node_update(pn, sysname);
+                changed = true;
+            }
+next:
+            udev_device_unref(dev);
+        }
+    }
+#endif /* RENAME_TRACKING_UDEV */
+    return changed;
+}
+
+#ifdef RENAME_TRACKING_RTNL
+/* Re-synchronizes the netdev name of every port in the table with the kernel.
+ *
+ * Used when the rtnetlink socket overflowed and we may have lost rename
+ * notifications. */
+static void
+rtnl_monitor_resync(void)
+{
+    struct port_node *pn;
+
+    CMAP_FOR_EACH (pn, ifindex_node, &port_table->ifindex_table) {
+        char name[IFNAMSIZ];
+
+        if (if_indextoname(pn->netdev_ifindex, name)
+            && strcmp(name, pn->netdev_name)) {
+            port_node_update(pn, name);
+            rtnl_monitor_changed = true;
+        }
+    }
+}
+
+static void
+rtnl_monitor_cb(const void *change_, void *aux OVS_UNUSED)
+{
+    const struct rtnetlink_change *change = change_;
+    struct port_node *pn;
+
+    if (!change) {
+        VLOG_WARN("rtnetlink monitor socket overflowed, re-synchronizing "
+                  "netdev names.");
+        rtnl_monitor_resync();
+        return;
+    }
+    if (change->nlmsg_type != RTM_NEWLINK || !change->ifname) {
+        return;
+    }
+
+    pn = port_table_lookup_ifindex(port_table, change->if_index);
+    if (!pn) {
+        /* The devlink notification for the port may not have arrived yet,
+         * remember the name for when it does. */
+        rename_buffer_record(change->if_index, change->ifname, false);
+        return;
+    }
+    if (!strcmp(pn->netdev_name, change->ifname)) {
+        /* Not a rename, ignore link state changes etc. */
+        return;
+    }
+    port_node_update(pn, change->ifname);
+    rtnl_monitor_changed = true;
+}
+
+static bool
+rtnl_monitor_parse(struct ofpbuf *buf, void *change)
+{
+    return rtnetlink_parse(buf, change);
+}
+
+static void
+rtnl_monitor_init(void)
+{
+    rtnl_monitor_nln = nln_create(NETLINK_ROUTE, rtnl_monitor_parse,
+                                  &rtnl_monitor_change);
+    rtnl_monitor_notifier = nln_notifier_create(rtnl_monitor_nln,
+                                                RTNLGRP_LINK,
+                                                rtnl_monitor_cb, NULL);
+    if (!rtnl_monitor_notifier) {
+        VLOG_ERR("unable to initialize rtnetlink monitor.");
+    }
+}
+
+static void
+rtnl_monitor_destroy(void)
+{
+    nln_notifier_destroy(rtnl_monitor_notifier);
+    rtnl_monitor_notifier = NULL;
+    nln_destroy(rtnl_monitor_nln);
+    rtnl_monitor_nln = NULL;
+}
+#endif /* RENAME_TRACKING_RTNL */
+
+/* Processes pending RTM_NEWLINK notifications and applies any netdev name
+ * changes to ports present in the table.
+ *
+ * Contrary to the udev monitor this does not need to retrieve any
+ * information from sysfs, all we need is provided in the notification, and
+ * the notifier uses a small fixed size receive buffer. */
+static bool
+rtnl_monitor_run(void)
+{
+    bool changed = false;
+#ifdef RENAME_TRACKING_RTNL
+    if (rtnl_monitor_notifier) {
+        nln_run(rtnl_monitor_nln);
+    }
+    changed = rtnl_monitor_changed;
+    rtnl_monitor_changed = false;
+#endif /* RENAME_TRACKING_RTNL */
+    return changed;
+}
+
+/* A new port is only worth waking the main loop up for once the netdev of
+ * its representor has been renamed, so changes are reported when both a
+ * devlink change and a rename have been seen.  The two usually arrive in
+ * separate drains of the monitor sockets, so they are remembered until then,
+ * see monitor_take_changes. */
+static bool monitor_devlink_changed OVS_GUARDED_BY(port_table_mutex);
+static bool monitor_rename_changed OVS_GUARDED_BY(port_table_mutex);
+
+static void
+monitor_note_changes(bool devlink_changed, bool rename_changed)
+    OVS_REQUIRES(port_table_mutex)
+{
+#ifndef RENAME_TRACKING
+    /* There is no rename to wait for. */
+    rename_changed = devlink_changed;
+#endif /* RENAME_TRACKING */
+    monitor_devlink_changed |= devlink_changed;
+    monitor_rename_changed |= rename_changed;
+}
+
+/* Returns true, and forgets about them, if both a devlink change and a
+ * rename were noted since the last time it returned true. */
+static bool
+monitor_take_changes(void)
+    OVS_REQUIRES(port_table_mutex)
+{
+    if (monitor_devlink_changed && monitor_rename_changed) {
+        monitor_devlink_changed = false;
+        monitor_rename_changed = false;
+        return true;
+    }
+    return false;
+}
+
+/* Drains the monitor sockets and returns true if any event was applied.
+ * Only one of the rename trackers is built in, the other one never reports a
+ * change. */
+static bool
+monitor_run(long long int deadline)
+    OVS_REQUIRES(port_table_mutex)
+{
+    bool devlink_changed = devlink_monitor_run(deadline);
+    bool rename_changed = udev_monitor_run(deadline) | rtnl_monitor_run();
+
+    monitor_note_changes(devlink_changed, rename_changed);
+    return devlink_changed || rename_changed;
+}
+
+/* Monitor thread.
+ *
+ * By default the monitor sockets are drained from vif_plug_representor_run,
+ * which means that a long ovn-controller main loop iteration, for example a
+ * full recompute, may let the devlink socket overflow.  When enabled through
+ * the CFG_MONITOR_THREAD key, a dedicated thread blocks on the monitor
+ * sockets and applies events to the port table as they arrive.  The main
+ * thread is woken up through 'monitor_seq' whenever the table changed, and
+ * decides with monitor_take_changes whether that is worth reporting.
+ *
+ * The thread is created the first time it is enabled, and lives until
+ * vif_plug_representor_destroy.  It only drains the sockets while
+ * 'monitor_thread_active' is set, which the main thread does once the
+ * initial dump is complete and the thread is enabled, and is told about
+ * changes to it through 'monitor_latch'.  The thread takes
+ * 'port_table_mutex', see struct port_table, while it applies events. */
+static bool monitor_thread_requested;
+static bool monitor_thread_created;
+static bool monitor_thread_active OVS_GUARDED_BY(port_table_mutex);
+static bool monitor_thread_exiting OVS_GUARDED_BY(port_table_mutex);
+static pthread_t monitor_thread;
+static struct latch monitor_latch;
+static struct seq *monitor_seq;
+static uint64_t monitor_seqno;
+
+static void
+monitor_wait(void)
+{
+    if (devlink_monitor_sock && !port_resync) {
+        nl_sock_wait(devlink_monitor_sock, POLLIN);
+    }
+#ifdef RENAME_TRACKING_UDEV
+    if (udev_monitor) {
+        poll_fd_wait(udev_monitor_get_fd(udev_monitor), POLLIN);
+    }
+#endif /* RENAME_TRACKING_UDEV */
+#ifdef RENAME_TRACKING_RTNL
+    if (rtnl_monitor_notifier) {
+        nln_wait(rtnl_monitor_nln);
+    }
+#endif /* RENAME_TRACKING_RTNL */
+}
+
+static void *
+monitor_thread_main(void *arg OVS_UNUSED)
+{
+    for (;;) {
+        bool changed = false;
+
+        latch_poll(&monitor_latch);
+        ovs_mutex_lock(&port_table_mutex);
+        if (monitor_thread_exiting) {
+            ovs_mutex_unlock(&port_table_mutex);
+            break;
+        }
+        if (monitor_thread_active) {
+            changed = monitor_run(LLONG_MAX);
+            monitor_wait();
+        }
+        ovs_mutex_unlock(&port_table_mutex);
+        if (changed) {
+            seq_change(monitor_seq);
+        }
+
+        latch_wait(&monitor_latch);
+        poll_block();
+    }
+    return NULL;
+}
+
+static void
+monitor_thread_create(void)
+{
+    monitor_seq = seq_create();
+    monitor_seqno = seq_read(monitor_seq);
+    latch_init(&monitor_latch);
+    monitor_thread = ovs_thread_create("representor_monitor",
+                                       monitor_thread_main, NULL);
+    monitor_thread_created = true;
+}
+
+static void
+monitor_thread_join(void)
+{
+    if (!monitor_thread_created) {
+        return;
+    }
+    ovs_mutex_lock(&port_table_mutex);
+    monitor_thread_exiting = true;
+    ovs_mutex_unlock(&port_table_mutex);
+    latch_set(&monitor_latch);
+    xpthread_join(monitor_thread, NULL);
+    latch_destroy(&monitor_latch);
+    seq_destroy(monitor_seq);
+    monitor_seq = NULL;
+    monitor_thread_created = false;
+
+    ovs_mutex_lock(&port_table_mutex);
+    monitor_thread_active = false;
+    monitor_thread_exiting = false;
+    ovs_mutex_unlock(&port_table_mutex);
+}
+
+/* Hands the monitor sockets over to the monitor thread if 'active', creating
+ * it if necessary, or back to the main thread otherwise.  Must be called with
+ * 'port_table_mutex' held. */
+static void
+monitor_thread_set_active(bool active)
+    OVS_REQUIRES(port_table_mutex)
+{
+    if (active == monitor_thread_active) {
+        return;
+    }
+    if (!monitor_thread_created) {
+        monitor_thread_create();
+    }
+    VLOG_INFO("%s representor monitor thread",
+              active ? "activating" : "deactivating");
+    monitor_thread_active = active;
+    latch_set(&monitor_latch);
+}
+
+/* Returns true if the monitor sockets, drained by either thread, reported
+ * changes worth waking up for since the last time it returned true, and
+ * arranges for the main loop to wake up on the next change made by the
+ * monitor thread. */
+static bool
+monitor_thread_run(void)
+{
+    bool changed;
+
+    if (monitor_thread_created) {
+        monitor_seqno = seq_read(monitor_seq);
+        seq_wait(monitor_seq, monitor_seqno);
+    }
+    ovs_mutex_lock(&port_table_mutex);
+    changed = monitor_take_changes();
+    ovs_mutex_unlock(&port_table_mutex);
+    return changed;
+}
+
+/* A port whose rename wait expired, refreshed from the kernel without
+ * holding 'port_table_mutex'. */
+struct rename_wait_job {
+    uint32_t netdev_ifindex;
+    char *netdev_name;          /* Name when the wait expired. */
+    char *bus_name;
+    char *dev_name;
+    uint32_t dl_port_index;
+};
+
+/* Ends the wait of the first port in 'rename_wait_list' if it expired at or
+ * before 'now', and stores in 'job' what is needed to refresh it.  Returns
+ * false if no wait expired. */
+static bool
+port_table_rename_wait_next(long long int now, struct rename_wait_job *job)
+    OVS_REQUIRES(port_table_mutex)
+{
+    const struct phy_node *phy;
+    struct port_node *pn;
+
+    if (ovs_list_is_empty(&rename_wait_list)) {
+        return false;
+    }
+    pn = CONTAINER_OF(ovs_list_front(&rename_wait_list),
+                      struct port_node, rename_wait_node);
+    if (pn->rename_wait_start + RENAME_WAIT_TIMEOUT_MSEC > now) {
+        poll_timer_wait_until(pn->rename_wait_start
+                              + RENAME_WAIT_TIMEOUT_MSEC);
+        return false;
+    }
+    port_node_rename_wait_done(pn, now, true);
+
+    phy = port_node_is_phy(pn) ? phy_node_cast(pn)
+                               : function_node_cast(pn)->pf;
+    job->netdev_ifindex = pn->netdev_ifindex;
+    job->netdev_name = xstrdup(pn->netdev_name);
+    job->bus_name = xstrdup(phy->bus_name);
+    job->dev_name = xstrdup(phy->dev_name);
+    job->dl_port_index = pn->dl_port_index;
+    return true;
+}
+
+/* Applies 'port_entry', the kernel's view of the port of 'job' or NULL if it
+ * could not be retrieved, and accepts the name of the port. */
+static void
+port_table_rename_wait_finish(const struct rename_wait_job *job,
+                              struct dl_port *port_entry)
+    OVS_REQUIRES(port_table_mutex)
+{
+    struct port_node *pn;
+
+    pn = port_table_lookup_ifindex(port_table, job->netdev_ifindex);
+    if (!pn || !ovs_list_is_empty(&pn->rename_wait_node)) {
+        /* Removed, or replaced by a port that is waiting anew. */
+        return;
+    }
+    if (port_entry && port_entry->netdev_ifindex != UINT32_MAX) {
+        port_table_update_devlink_port(port_entry, PORT_NODE_SOURCE_RUNTIME);
+        if (strcmp(job->netdev_name, pn->netdev_name)) {
+            VLOG_INFO("netdev with ifindex %"PRIu32" was renamed from %s to "
+                      "%s without us noticing.",
+                      pn->netdev_ifindex, job->netdev_name, pn->netdev_name);
+            rename_wait_stats.n_resolved++;
+            return;
+        }
+    }
+    VLOG_INFO("netdev %s was not renamed within %d ms, accepting current "
+              "name.", pn->netdev_name, RENAME_WAIT_TIMEOUT_MSEC);
+    pn->netdev_renamed = true;
+}
+
+/* Maximum number of expired rename waits refreshed with one batch of devlink
+ * requests. */
+#define RENAME_WAIT_BATCH_MAX 64
+
+/* Expires rename waits with a deadline at or before 'now'.
+ *
+ * The name of the netdev of each expired port is re-resolved with a targeted
+ * query to the kernel, in case we missed the rename, and then accepted.  The
+ * queries for up to RENAME_WAIT_BATCH_MAX ports are pipelined in one batch,
+ * so that a firmware event that recreates hundreds of ports costs a handful
+ * of system calls.  They are made without holding 'port_table_mutex', which
+ * is only taken to pick the expired ports and to apply the replies, so this
+ * must not be called with it held.
+ *
+ * Returns true if any port became available for plugging. */
+static bool
+port_table_rename_wait_run(long long int now, long long int deadline)
+{
+    struct devlink_port_query queries[RENAME_WAIT_BATCH_MAX];
+    struct rename_wait_job jobs[RENAME_WAIT_BATCH_MAX];
+    bool changed = false;
+
+    for (size_t i = 0; !run_budget_exhausted(deadline, i); i++) {
+        struct nl_dl_batch *batch;
+        size_t n = 0;
+
+        ovs_mutex_lock(&port_table_mutex);
+        while (n < RENAME_WAIT_BATCH_MAX
+               && port_table_rename_wait_next(now, &jobs[n])) {
+            n++;
+        }
+        ovs_mutex_unlock(&port_table_mutex);
+        if (!n) {
+            break;
+        }
+
+        for (size_t j = 0; j < n; j++) {
+            queries[j].bus_name = jobs[j].bus_name;
+            queries[j].dev_name = jobs[j].dev_name;
+            queries[j].port_index = jobs[j].dl_port_index;
+        }
+        batch = devlink_port_get_batch(queries, n);
+
+        ovs_mutex_lock(&port_table_mutex);
+        for (size_t j = 0; j < n; j++) {
+            struct devlink_port_query *q = &queries[j];
+
+            if (q->error && q->port_index != UINT32_MAX) {
+                VLOG_WARN("unable to refresh devlink port %s/%s/%"PRIu32": "
+                          "%s", q->bus_name, q->dev_name, q->port_index,
+                          ovs_strerror(q->error));
+            }
+            port_table_rename_wait_finish(&jobs[j],
+                                          q->error ? NULL : &q->port_entry);
+        }
+        ovs_mutex_unlock(&port_table_mutex);
+        changed = true;
+
+        nl_dl_batch_destroy(batch);
+        for (size_t j = 0; j < n; j++) {
+            free(jobs[j].netdev_name);
+            free(jobs[j].bus_name);
+            free(jobs[j].dev_name);
+        }
+    }
+    return changed;
+}
+
+/* Carries out queued SF requests until 'deadline'.  The devlink transactions
+ * are made without holding 'port_table_mutex', which is only taken to pick a
+ * request and to record its outcome.  Must only be called from the main
+ * loop.
+ *
+ * Returns true if a representor was added to the table. */
+static bool
+port_table_sf_requests_run(struct port_table *tbl, long long int deadline)
+{
+    bool changed = false;
+
+    for (size_t i = 0; !run_budget_exhausted(deadline, i); i++) {
+        struct dl_port port_entry;
+        struct ofpbuf *buf = NULL;
+        struct sf_job job;
+        bool found;
+        int error;
+
+        ovs_mutex_lock(&port_table_mutex);
+        found = port_table_sf_request_next(tbl, time_msec(), &job);
+        ovs_mutex_unlock(&port_table_mutex);
+        if (!found) {
+            break;
+        }
+
+        error = sf_create(job.bus_name, job.dev_name, job.pci_pf_number,
+                          job.controller, job.sf_num, job.mac, &port_entry,
+                          &buf);
+
+        ovs_mutex_lock(&port_table_mutex);
+        changed |= port_table_sf_request_finish(tbl, &job, error,
+                                                &port_entry);
+        ovs_mutex_unlock(&port_table_mutex);
+
+        ofpbuf_delete(buf);
+        free(job.bus_name);
+        free(job.dev_name);
+    }
+    return changed;
+}
+
+static int devlink_param_get(const char *bus_name, const char *dev_name,
+                             const char *name, struct dl_param *,
+                             struct ofpbuf **bufp);
+static int devlink_param_set(const char *bus_name, const char *dev_name,
+                             const char *name, uint8_t type,
+                             const struct dl_param_value *);
+
+static void
+devlink_params_clear(void)
+{
+    struct devlink_param_entry *entry;
+
+    LIST_FOR_EACH_POP (entry, list_node, &devlink_params) {
+        free(entry->bus_name);
+        free(entry->dev_name);
+        free(entry->name);
+        free(entry->value);
+        free(entry);
+    }
+}
+
+/* Replaces the parameter profile with the one described by 'cfg', unless
+ * that is the profile already in place. */
+static void
+devlink_params_configure(const char *cfg)
+{
+    char *copy, *token, *save_ptr = NULL;
+
+    if (devlink_params_cfg && !strcmp(cfg, devlink_params_cfg)) {
+        return;
+    }
+    free(devlink_params_cfg);
+    devlink_params_cfg = xstrdup(cfg);
+    devlink_params_clear();
+    devlink_params_next_run = 0;
+
+    copy = xstrdup(cfg);
+    for (token = strtok_r(copy, ", ", &save_ptr); token;
+         token = strtok_r(NULL, ", ", &save_ptr)) {
+        struct devlink_param_entry *entry;
+        char *dev_name, *name, *value;
+
+        dev_name = strchr(token, '/');
+        name = dev_name ? strchr(dev_name + 1, '/') : NULL;
+        value = name ? strchr(name + 1, '=') : NULL;
+        if (!value || dev_name == token || name == dev_name + 1
+            || value == name + 1) {
+            VLOG_WARN("%s: ignoring malformed entry '%s', expected "
+                      "bus/dev/name=value", CFG_DEVLINK_PARAMS, token);
+            continue;
+        }
+        *dev_name++ = '\0';
+        *name++ = '\0';
+        *value++ = '\0';
+
+        entry = xmalloc(sizeof *entry);
+        entry->bus_name = xstrdup(token);
+        entry->dev_name = xstrdup(dev_name);
+        entry->name = xstrdup(name);
+        entry->value = xstrdup(value);
+        entry->error = 0;
+        entry->checked = false;
+        ovs_list_push_back(&devlink_params, &entry->list_node);
+    }
+    free(copy);
+}
+
+/* Parses 's' as a value of a devlink parameter of type 'type' into 'value',
+ * which refers to 's' for string parameters. */
+static bool
+devlink_param_value_from_string(uint8_t type, const char *s,
+                                struct dl_param_value *value)
+{
+    unsigned long long int data, max;
+
+    value->data = 0;
+    value->string = dl_str_not_present;
+    switch (type) {
+    case DL_PARAM_TYPE_U8:
+        max = UINT8_MAX;
+        break;
+    case DL_PARAM_TYPE_U16:
+        max = UINT16_MAX;
+        break;
+    case DL_PARAM_TYPE_U32:
+        max = UINT32_MAX;
+        break;
+    case DL_PARAM_TYPE_U64:
+        max = UINT64_MAX;
+        break;
+    case DL_PARAM_TYPE_BOOL:
+        if (!strcmp(s, "true")) {
+            value->data = 1;
+        } else if (strcmp(s, "false")) {
+            return false;
+        }
+        return true;
+    case DL_PARAM_TYPE_STRING:
+        value->string = s;
+        return true;
+    default:
+        return false;
+    }
+    if (!str_to_ullong(s, 10, &data) || data > max) {
+        return false;
+    }
+    value->data = data;
+    return true;
+}
+
+static bool
+devlink_param_value_equals(uint8_t type, const struct dl_param_value *a,
+                           const struct dl_param_value *b)
+{
+    return (type == DL_PARAM_TYPE_STRING
+            ? !strcmp(a->string, b->string)
+            : a->data == b->data);
+}
+
+static void
+devlink_param_value_format(uint8_t type, const struct dl_param_value *value,
+                           struct ds *s)
+{
+    if (type == DL_PARAM_TYPE_STRING) {
+        ds_put_cstr(s, value->string);
+    } else if (type == DL_PARAM_TYPE_BOOL) {
+        ds_put_cstr(s, value->data ? "true" : "false");
+    } else {
+        ds_put_format(s, "%"PRIu64, value->data);
+    }
+}
+
+/* Returns the value of 'param' in the configuration mode we manage it in,
+ * or NULL if there is none.  Permanent values are stored in the flash of the
+ * device and are left to the administrator. */
+static const struct dl_param_value *
+devlink_param_find_value(const struct dl_param *param)
+{
+    const struct dl_param_value *driverinit = NULL;
+
+    for (size_t i = 0; i < param->n_values; i++) {
+        if (param->values[i].cmode == DEVLINK_PARAM_CMODE_RUNTIME) {
+            return &param->values[i];
+        } else if (param->values[i].cmode == DEVLINK_PARAM_CMODE_DRIVERINIT) {
+            driverinit = &param->values[i];
+        }
+    }
+    return driverinit;
+}
+
+/* Sets the parameter of 'entry' to its desired value if it has a different
+ * one, and reads it back.  Stores the configuration mode the value was set
+ * in to '*set_cmode', or UINT8_MAX if the value was left alone.
+ *
+ * Returns 0 if the parameter has the desired value, otherwise a positive
+ * errno value, in which case the current value is appended to 'current' if
+ * it is known. */
+static int
+devlink_param_check(const struct devlink_param_entry *entry,
+                    uint8_t *set_cmode, struct ds *current)
+{
+    const struct dl_param_value *cur;
+    struct dl_param_value desired;
+    struct dl_param param;
+    struct ofpbuf *buf;
+    int error;
+
+    *set_cmode = UINT8_MAX;
+    error = devlink_param_get(entry->bus_name, entry->dev_name, entry->name,
+                              &param, &buf);
+    if (error) {
+        return error;
+    }
+
+    cur = devlink_param_find_value(&param);
+    if (!cur) {
+        error = EOPNOTSUPP;
+        goto out;
+    }
+    if (!devlink_param_value_from_string(param.type, entry->value,
+                                         &desired)) {
+        error = EINVAL;
+        goto out;
+    }
+    if (devlink_param_value_equals(param.type, cur, &desired)) {
+        goto out;
+    }
+
+    desired.cmode = cur->cmode;
+    error = devlink_param_set(entry->bus_name, entry->dev_name, entry->name,
+                              param.type, &desired);
+    if (error) {
+        goto out;
+    }
+    *set_cmode = desired.cmode;
+    ofpbuf_delete(buf);
+
+    /* Read the value back, a driver accepting a value that it then does not
+     * apply should not go unnoticed. */
+    error = devlink_param_get(entry->bus_name, entry->dev_name, entry->name,
+                              &param, &buf);
+    if (error) {
+        return error;
+    }
+    cur = devlink_param_find_value(&param);
+    if (!cur || !devlink_param_value_equals(param.type, cur, &desired)) {
+        error = EIO;
+    }
+
+out:
+    if (error && cur) {
+        devlink_param_value_format(param.type, cur, current);
+    }
+    ofpbuf_delete(buf);
+    return error;
+}
+
+/* Returns true if an entry of the parameter profile was not checked yet. */
+static bool
+devlink_params_pending(void)
+{
+    struct devlink_param_entry *entry;
+
+    LIST_FOR_EACH (entry, list_node, &devlink_params) {
+        if (!entry->checked) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Checks the parameter profile against the devices, at most once every
+ * DEVLINK_PARAMS_RUN_INTERVAL_MSEC.  Failures are logged when they first
+ * occur and retried silently from then on, until the parameter has its
+ * desired value again.
+ *
+ * Returns true if entries were checked for the first time, which means that
+ * lports held back by devlink_params_pending may be plugged now. */
+static bool
+devlink_params_run(long long int now)
+{
+    struct devlink_param_entry *entry;
+    bool pending;
+
+    if (ovs_list_is_empty(&devlink_params)) {
+        return false;
+    }
+    if (now < devlink_params_next_run) {
+        poll_timer_wait_until(devlink_params_next_run);
+        return false;
+    }
+    pending = devlink_params_pending();
+    devlink_params_next_run = now + DEVLINK_PARAMS_RUN_INTERVAL_MSEC;
+
+    LIST_FOR_EACH (entry, list_node, &devlink_params) {
+        struct ds current = DS_EMPTY_INITIALIZER;
+        uint8_t set_cmode;
+        int error;
+
+        error = devlink_param_check(entry, &set_cmode, &current);
+        if (!error && set_cmode != UINT8_MAX) {
+            VLOG_INFO("devlink param %s of %s/%s set to '%s'%s",
+                      entry->name, entry->bus_name, entry->dev_name,
+                      entry->value,
+                      set_cmode == DEVLINK_PARAM_CMODE_DRIVERINIT
+                      ? ", effective after reload of the device" : "");
+        } else if (!error && entry->error) {
+            VLOG_INFO("devlink param %s of %s/%s is '%s' again",
+                      entry->name, entry->bus_name, entry->dev_name,
+                      entry->value);
+        } else if (error && error != entry->error) {
+            if (current.length) {
+                VLOG_WARN("devlink param %s of %s/%s is '%s' instead of "
+                          "'%s': %s", entry->name, entry->bus_name,
+                          entry->dev_name, ds_cstr(&current), entry->value,
+                          ovs_strerror(error));
+            } else {
+                VLOG_WARN("unable to set devlink param %s of %s/%s to "
+                          "'%s': %s", entry->name, entry->bus_name,
+                          entry->dev_name, entry->value,
+                          ovs_strerror(error));
+            }
+        }
+        entry->error = error;
+        entry->checked = true;
+        ds_destroy(&current);
+    }
+    poll_timer_wait_until(devlink_params_next_run);
+    return pending;
+}
+
+/* Reads the CFG_* keys from 'ovs_table'.  Only port_prepare has access to the
+ * database, so the defaults apply until the first lport with representor
+ * options is processed, and changes take effect with the next one. */
+static void
+vif_plug_representor_configure(
+    const struct ovsrec_open_vswitch_table *ovs_table)
+{
+    const struct ovsrec_open_vswitch *cfg;
+
+    cfg = ovs_table ? ovsrec_open_vswitch_table_first(ovs_table) : NULL;
+    if (!cfg) {
+        return;
+    }
+    monitor_thread_requested = smap_get_bool(&cfg->other_config,
+                                             CFG_MONITOR_THREAD, false);
+    run_budget_msec = smap_get_uint(&cfg->other_config, CFG_RUN_BUDGET_MSEC,
+                                    RUN_BUDGET_MSEC_DEFAULT);
+    sf_provisioning = smap_get_bool(&cfg->other_config, CFG_SF_PROVISIONING,
+                                    false);
+    sf_pool_size = smap_get_uint(&cfg->other_config, CFG_SF_POOL_SIZE, 0);
+    devlink_params_configure(smap_get_def(&cfg->other_config,
+                                          CFG_DEVLINK_PARAMS, ""));
+}
+
+static int
+vif_plug_representor_init(void)
+{
+    int error;
+
+    unixctl_command_register("vif-plug-representor/rename-wait-stats", "",
+                             0, 0, rename_wait_stats_unixctl, NULL);
+
+    sset_add(&maintained_iface_options, OPT_PF_MAC);
+    sset_add(&maintained_iface_options, OPT_VF_NUM);
+    sset_add(&maintained_iface_options, OPT_SF_NUM);
+    sset_add(&maintained_iface_options, OPT_IFINDEX);
+    sset_add(&maintained_iface_options, OPT_SF_PROVISIONED);
+
+    error = devlink_monitor_init();
+    if (error) {
+        return error;
+    }
+
+    error = devlink_port_dump_start();
+    if (error) {
+        return error;
+    }
+
+#ifdef RENAME_TRACKING_UDEV
+    udev_monitor_init();
+#endif /* RENAME_TRACKING_UDEV */
+#ifdef RENAME_TRACKING_RTNL
+    rtnl_monitor_init();
+#endif /* RENAME_TRACKING_RTNL */
+
+    return 0;
+}
+
+/* Called from the main loop with 'plug_class' set, and by port_prepare
+ * with a NULL 'plug_class' to bring the table up to date before each
+ * lookup. */
+static bool
+vif_plug_representor_run(struct vif_plug_class *plug_class)
+{
+    bool from_main_loop = plug_class != NULL;
+    bool changed = false;
+
+    if (from_main_loop) {
+        run_deadline = run_budget_deadline();
+        /* Parameters such as the flow steering mode matter before any flow
+         * is offloaded, port_prepare holds lports back until each of them
+         * was checked once, so they are not held back by the initial dump.
+         * Checking them involves devlink transactions, which stay off the
+         * plug path. */
+        changed = devlink_params_run(time_msec());
+    } else if (time_msec() >= run_deadline) {
+        /* The budget of this main loop iteration is used up. */
+        return false;
+    }
+
+    if (port_dump) {
+        /* Notifications are left queued on the monitor sockets until the
+         * initial dump is complete, so that they are applied on top of it in
+         * the order they occurred.  The dump is only processed from the main
+         * loop, which needs to learn that it completed. */
+        return (from_main_loop && devlink_port_dump_run(run_deadline))
+               || changed;
+    }
+
+    ovs_mutex_lock(&port_table_mutex);
+    /* The monitor thread only takes over once the initial dump is complete,
+     * for the same reason as above. */
+    monitor_thread_set_active(monitor_thread_requested);
+    if (from_main_loop) {
+        port_table_dump_retry_run(port_table, time_msec());
+        changed |= port_table_resync_run(port_table, run_deadline);
+    }
+    if (!monitor_thread_active) {
+        /* The rtnetlink notifier does not allow partial processing, it is
+         * cheap enough per message that it is left out of the budget. */
+        monitor_run(run_deadline);
+    }
+    if (from_main_loop) {
+        changed |= port_table_compat_run(port_table, time_msec());
+        port_table_pending_run(port_table, time_msec());
+        port_table_sf_pool_run(port_table, time_msec());
+    }
+    ovs_mutex_unlock(&port_table_mutex);
+
+    if (from_main_loop) {
+        /* These block for the duration of devlink transactions, so they are
+         * kept off the plug path. */
+        changed |= port_table_rename_wait_run(time_msec(), run_deadline);
+        changed |= port_table_sf_requests_run(port_table, run_deadline);
+    }
+
+    return monitor_thread_run() || changed;
+}
+
+static int
+vif_plug_representor_destroy(void)
+{
+    monitor_thread_join();
+#ifdef RENAME_TRACKING_RTNL
+    rtnl_monitor_destroy();
+#endif /* RENAME_TRACKING_RTNL */
+    if (port_resync) {
+        nl_dl_async_dump_destroy(port_resync);
+        port_resync = NULL;
+    }
+    if (port_dump) {
+        nl_dl_async_dump_destroy(port_dump);
+        port_dump = NULL;
+    } else {
+        char *snapshot_file_name = port_snapshot_file_name();
+
+        port_snapshot_write(port_table, snapshot_file_name);
+        free(snapshot_file_name);
+    }
+    port_table_destroy(port_table);
+    rename_buffer_clear();
+    devlink_params_clear();
+    free(devlink_params_cfg);
+    devlink_params_cfg = NULL;
+    sset_destroy(&maintained_iface_options);
+
+    return 0;
+}
+
+static const struct sset *
+vif_plug_representor_get_maintained_iface_options(void)
+{
+    return &maintained_iface_options;
+}
+
+/* Fills 'iface_options' with the Interface options maintained by this
+ * provider for the representor port 'pn'.
+ *
+ * Only values that identify the representor are provided, and they are
+ * rendered in a canonical form so that repeated calls for an unchanged
+ * representor produce identical options.  This allows ovn-controller to skip
+ * the OVSDB update entirely on recompute. */
+static void
+port_node_fill_iface_options(const struct port_node *pn,
+                             struct smap *iface_options)
+{
+    smap_add_format(iface_options, OPT_PF_MAC, ETH_ADDR_FMT,
+                    ETH_ADDR_ARGS(function_node_cast(pn)->pf->up.mac));
+    smap_add_format(iface_options,
+                    pn->flavour == DEVLINK_PORT_FLAVOUR_PCI_SF
+                    ? OPT_SF_NUM : OPT_VF_NUM,
+                    "%"PRIu32, pn->number);
+    smap_add_format(iface_options, OPT_IFINDEX, "%"PRIu32,
+                    pn->netdev_ifindex);
+    if (function_node_cast(pn)->provisioned) {
+        smap_add(iface_options, OPT_SF_PROVISIONED, "true");
+    }
+}
+
+/* Marks the SF represented by 'pn' as created by us if the Interface options
+ * 'iface_options' we maintain say so, which is how ownership of the SF
+ * survives a restart of ovn-controller. */
+static void
+port_node_adopt_sf(struct port_node *pn, const struct smap *iface_options)
+{
+    const char *opt_pf_mac = smap_get(iface_options, OPT_PF_MAC);
+    const char *opt_sf_num = smap_get(iface_options, OPT_SF_NUM);
+    struct function_node *fn;
+    struct eth_addr pf_mac;
+    unsigned int sf_num;
+
+    if (pn->flavour != DEVLINK_PORT_FLAVOUR_PCI_SF
+        || !smap_get_bool(iface_options, OPT_SF_PROVISIONED, false)
+        || !opt_pf_mac || !opt_sf_num
+        || !eth_addr_from_string(opt_pf_mac, &pf_mac)
+        || !str_to_uint(opt_sf_num, 10, &sf_num)) {
+        return;
+    }
+    fn = function_node_cast(pn);
+    if (eth_addr_equals(fn->pf->up.mac, pf_mac) && sf_num == pn->number) {
+        fn->provisioned = true;
+    }
+}
+
+/* Deletes the SF plugged for the lport 'lport_name' being removed, which is
+ * identified by the Interface options 'iface_options' we maintain, as the
+ * lport options may be gone by now.  SFs that were not created by us are
+ * left alone. */
+static void
+vif_plug_representor_remove_sf(const char *lport_name,
+                               const struct smap *iface_options)
+{
+    const char *opt_pf_mac = smap_get(iface_options, OPT_PF_MAC);
+    const char *opt_sf_num = smap_get(iface_options, OPT_SF_NUM);
+    struct eth_addr pf_mac;
+    unsigned int sf_num;
+    struct port_node *pn;
+    int error;
+
+    if (!smap_get_bool(iface_options, OPT_SF_PROVISIONED, false)
+        || !opt_pf_mac || !opt_sf_num
+        || !eth_addr_from_string(opt_pf_mac, &pf_mac)
+        || !str_to_uint(opt_sf_num, 10, &sf_num)) {
+        return;
+    }
+
+    ovs_mutex_lock(&port_table_mutex);
+    pn = port_table ? port_table_lookup_pf_mac_sf(port_table, pf_mac, sf_num)
+                    : NULL;
+    error = pn ? port_node_delete_sf(pn) : ENODEV;
+    ovs_mutex_unlock(&port_table_mutex);
+
+    if (error) {
+        VLOG_WARN("Unable to delete SF of lport: %s pf-mac: '%s' "
+                  "sf-num: '%s': %s", lport_name, opt_pf_mac,
+                  opt_sf_num, ovs_strerror(error));
+    }
+}
+
+static bool
+vif_plug_representor_port_prepare(const struct vif_plug_port_ctx_in *ctx_in,
+                                 struct vif_plug_port_ctx_out *ctx_out)
+{
+    if (ctx_in->op_type == PLUG_OP_REMOVE) {
+        vif_plug_representor_configure(ctx_in->ovs_table);
+        if (sf_provisioning) {
+            vif_plug_representor_remove_sf(ctx_in->lport_name,
+                                           &ctx_in->iface_options);
+        }
+        return true;
+    }
+    const char *opt_function_mac = smap_get(&ctx_in->lport_options,
+                                   "vif-plug:representor:function-mac");
+    const char *opt_pci_address = smap_get(&ctx_in->lport_options,
+                                   "vif-plug:representor:pci-address");
+    const char *opt_pf_mac = smap_get(&ctx_in->lport_options,
+                                   "vif-plug:representor:pf-mac");
+    const char *opt_vf_num = smap_get(&ctx_in->lport_options,
+                                   "vif-plug:representor:vf-num");
+    const char *opt_sf_num = smap_get(&ctx_in->lport_options,
+                                   "vif-plug:representor:sf-num");
+    const char *opt_host_mac = smap_get(&ctx_in->lport_options,
+                                   "vif-plug:representor:host-mac");
+    bool opt_sf_pool = smap_get_bool(&ctx_in->lport_options,
+                                     "vif-plug:representor:sf-pool", false);
+    if (!opt_function_mac && !opt_pci_address
+        && (!opt_pf_mac || (!opt_vf_num && !opt_sf_num && !opt_sf_pool))) {
+         return false;
+    }
+
+    /* Ensure lookup tables are up to date */
+    vif_plug_representor_configure(ctx_in->ovs_table);
+    vif_plug_representor_run(NULL);
+
+    if (devlink_params_pending()) {
+        static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+        /* Checked by the next run of the main loop. */
+        VLOG_INFO_RL(&rl, "Devlink params not checked yet, deferring "
+                     "plug/update of lport: %s", ctx_in->lport_name);
+        poll_immediate_wake();
+        return false;
+    }
+
+    if (!port_table_ready) {
+        static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+        VLOG_INFO_RL(&rl, "Representor port table not populated yet, "
+                     "deferring plug/update of lport: %s",
+                     ctx_in->lport_name);
+        return false;
+    }
+
+    struct eth_addr function_mac = eth_addr_zero;
+    struct eth_addr host_mac = eth_addr_zero;
+    struct eth_addr pf_mac = eth_addr_zero;
+    uint32_t bdf = PCI_BDF_NONE;
+    unsigned int sf_num = 0;
+    uint16_t vf_num = 0;
+
+    /* The function MAC and the PCI address each identify the representor on
+     * their own and take precedence over the PF MAC and VF number. */
+    if (opt_function_mac) {
+        if (!eth_addr_from_string(opt_function_mac, &function_mac)
+            || eth_addr_is_zero(function_mac)) {
+            VLOG_WARN("Unable to parse option as Ethernet address for "
+                      "lport: %s function-mac: '%s'",
+                      ctx_in->lport_name, opt_function_mac);
+            return false;
+        }
+    } else if (opt_pci_address) {
+        if (!pci_bdf_from_string(opt_pci_address, &bdf)) {
+            VLOG_WARN("Unable to parse option as PCI address for "
+                      "lport: %s pci-address: '%s'",
+                      ctx_in->lport_name, opt_pci_address);
+            return false;
+        }
+    } else if (opt_sf_pool) {
+        if (!eth_addr_from_string(opt_pf_mac, &pf_mac) || !opt_host_mac) {
+            VLOG_WARN("Unable to parse options for lport: %s pf-mac: '%s' "
+                      "sf-pool: true, host-mac is required",
+                      ctx_in->lport_name, opt_pf_mac);
+            return false;
+        }
+    } else if (opt_sf_num) {
+        if (!eth_addr_from_string(opt_pf_mac, &pf_mac)
+            || !str_to_uint(opt_sf_num, 10, &sf_num)) {
+            VLOG_WARN("Unable to parse options for lport: %s pf-mac: '%s' "
+                      "sf-num: '%s'",
+                      ctx_in->lport_name, opt_pf_mac, opt_sf_num);
+            return false;
+        }
+    } else {
+        if (!eth_addr_from_string(opt_pf_mac, &pf_mac)) {
+            VLOG_WARN("Unable to parse option as Ethernet address for "
+                      "lport: %s pf-mac: '%s' vf-num: '%s'",
+                      ctx_in->lport_name, opt_pf_mac, opt_vf_num);
+            return false;
+        }
+
+        char *cp = NULL;
+        vf_num = strtol(opt_vf_num, &cp, 10);
+        if (cp && cp != opt_vf_num && *cp != '\0') {
+            VLOG_WARN("Unable to parse option as VF number for lport: %s "
+                      "pf-mac: '%s' vf-num: '%s'",
+                      ctx_in->lport_name, opt_pf_mac, opt_vf_num);
+        }
+    }
+
+    if (opt_host_mac && (!eth_addr_from_string(opt_host_mac, &host_mac)
+                         || eth_addr_is_zero(host_mac)
+                         || eth_addr_is_multicast(host_mac))) {
+        VLOG_WARN("Unable to parse option as unicast Ethernet address for "
+                  "lport: %s host-mac: '%s'",
+                  ctx_in->lport_name, opt_host_mac);
+        return false;
+    }
+
+    struct port_node *pn;
+    bool retval = false;
+
+    ovs_mutex_lock(&port_table_mutex);
+    if (opt_function_mac) {
+        pn = port_table_lookup_function_mac(port_table, function_mac);
+    } else if (opt_pci_address) {
+        pn = port_table_lookup_bdf(port_table, bdf);
+    } else if (opt_sf_pool) {
+        struct phy_node *pf = port_table_lookup_pf_mac(port_table, pf_mac);
+        int error = pf ? port_table_sf_pool_claim(port_table, pf, host_mac,
+                                                  &pn)
+                       : ENODEV;
+
+        if (error) {
+            static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+
+            VLOG_WARN_RL(&rl, "Unable to claim SF for lport: %s "
+                         "pf-mac: '%s' host-mac: '%s': %s",
+                         ctx_in->lport_name, opt_pf_mac, opt_host_mac,
+                         ovs_strerror(error));
+            goto out;
+        } else if (!pn) {
+            static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+
+            VLOG_INFO_RL(&rl, "Waiting for SF to be created for lport: %s "
+                         "pf-mac: '%s' host-mac: '%s'",
+                         ctx_in->lport_name, opt_pf_mac, opt_host_mac);
+            goto out;
+        }
+    } else if (opt_sf_num) {
+        pn = port_table_lookup_pf_mac_sf(port_table, pf_mac, sf_num);
+    } else {
+        pn = port_table_lookup_pf_mac_vf(port_table, pf_mac, vf_num);
+    }
+
+    if (!pn && opt_sf_num && sf_provisioning) {
+        struct phy_node *pf = port_table_lookup_pf_mac(port_table, pf_mac);
+
+        if (!pf) {
+            static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+
+            VLOG_WARN_RL(&rl, "Unable to create SF for lport: %s "
+                         "pf-mac: '%s' sf-num: '%s': %s",
+                         ctx_in->lport_name, opt_pf_mac, opt_sf_num,
+                         ovs_strerror(ENODEV));
+        } else if (phy_node_request_sf(pf, sf_num, host_mac)) {
+            /* The SF is created from the main loop, and the lport plugged
+             * once its representor is reported. */
+            VLOG_INFO("Creating SF for lport: %s pf-mac: '%s' sf-num: '%s', "
+                      "waiting for its representor",
+                      ctx_in->lport_name, opt_pf_mac, opt_sf_num);
+        }
+        goto out;
+    }
+
+    if (!pn || !pn->netdev_name) {
+        if (opt_function_mac) {
+            VLOG_INFO("No representor port found for "
+                      "lport: %s function-mac: '%s'",
+                      ctx_in->lport_name, opt_function_mac);
+        } else if (opt_pci_address) {
+            VLOG_INFO("No representor port found for "
+                      "lport: %s pci-address: '%s'",
+                      ctx_in->lport_name, opt_pci_address);
+        } else if (opt_sf_num) {
+            VLOG_INFO("No representor port found for "
+                      "lport: %s pf-mac: '%s' sf-num: '%s'",
+                      ctx_in->lport_name, opt_pf_mac, opt_sf_num);
+        } else {
+            VLOG_INFO("No representor port found for "
+                      "lport: %s pf-mac: '%s' vf-num: '%s'",
+                      ctx_in->lport_name, opt_pf_mac, opt_vf_num);
+        }
+        goto out;
+    } else if (port_node_rename_expected(pn)) {
+        static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+
+        VLOG_INFO_RL(&rl, "Lookup of representor port successful, but we "
+                     "anticipate the netdev name to change, refusing "
+                     "plug/update of lport: %s current netdev_name: %s "
+                     "waited: %lld ms",
+                     ctx_in->lport_name, pn->netdev_name,
+                     time_msec() - pn->rename_wait_start);
+        goto out;
+    }
+
+    if (opt_host_mac) {
+        char *netdev_name = xstrdup(pn->netdev_name);
+        int error = port_table_set_function_mac(port_table, &pn, host_mac);
+
+        if (error) {
+            static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+
+            VLOG_WARN_RL(&rl, "Unable to set host MAC of representor port, "
+                         "refusing plug/update of lport: %s netdev_name: %s "
+                         "host-mac: '%s': %s",
+                         ctx_in->lport_name, netdev_name, opt_host_mac,
+                         ovs_strerror(error));
+        }
+        free(netdev_name);
+        if (error) {
+            goto out;
+        }
+    }
+
+    if (!port_node_is_phy(pn)) {
+        /* OVN expresses the QoS of a logical port in bit/s. */
+        uint64_t qos_min_rate = smap_get_ullong(&ctx_in->lport_options,
+                                                "qos_min_rate", 0);
+        uint64_t qos_max_rate = smap_get_ullong(&ctx_in->lport_options,
+                                                "qos_max_rate", 0);
+        const char *opt_rate_group = smap_get_def(&ctx_in->lport_options,
+                                         "vif-plug:representor:rate-group",
+                                         "");
+        char *netdev_name = xstrdup(pn->netdev_name);
+        int error = port_table_set_rate(port_table, &pn, qos_min_rate / 8,
+                                        qos_max_rate / 8, opt_rate_group);
+
+        if (error) {
+            static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 20);
+
+            /* Traffic still flows without the rate limits, so do not hold
+             * up the plug on them, the next update of the lport retries. */
+            VLOG_WARN_RL(&rl, "Unable to apply rates to representor port of "
+                         "lport: %s netdev_name: %s: %s",
+                         ctx_in->lport_name, netdev_name,
+                         ovs_strerror(error));
+        }
+        free(netdev_name);
+        if (!pn) {
+            /* Removed while the rates were applied. */
+            goto out;
+        }
+    }
+
+    port_node_adopt_sf(pn, &ctx_in->iface_options);
+    if (ctx_out) {
+        /* ovn-controller may hold on to 'ctx_out' until the transaction
+         * plugging the port completes, which can be several main loop
+         * iterations later, so it gets a copy of the name rather than one
+         * that a rename frees after the next quiescent period. */
+        ctx_out->name = xstrdup(pn->netdev_name);
+        ctx_out->type = NULL;
+        smap_init(&ctx_out->iface_options);
+        port_node_fill_iface_options(pn, &ctx_out->iface_options);
+    }
+    retval = true;
+
+out:
+    ovs_mutex_unlock(&port_table_mutex);
+    return retval;
+}
+
+static void
+vif_plug_representor_port_finish(
+        const struct vif_plug_port_ctx_in *ctx_in OVS_UNUSED,
+        struct vif_plug_port_ctx_out *ctx_out OVS_UNUSED)
+{
+    /* Nothing to be done here for now */
+}
+
+static void
+vif_plug_representor_port_ctx_destroy(
+        const struct vif_plug_port_ctx_in *ctx_in,
+        struct vif_plug_port_ctx_out *ctx_out)
+{
+    /* The name and the options were allocated on behalf of the caller in
+     * port_prepare. */
+    if (ctx_in->op_type == PLUG_OP_CREATE) {
+        free(ctx_out->name);
+        smap_destroy(&ctx_out->iface_options);
+    }
+}
+
+const struct vif_plug_class vif_plug_representor = {
+    .type = "representor",
+    .init = vif_plug_representor_init,
+    .destroy = vif_plug_representor_destroy,
+    .vif_plug_get_maintained_iface_options =
+        vif_plug_representor_get_maintained_iface_options,
+    .run = vif_plug_representor_run,
+    .vif_plug_port_prepare = vif_plug_representor_port_prepare,
+    .vif_plug_port_finish = vif_plug_representor_port_finish,
+    .vif_plug_port_ctx_destroy = vif_plug_representor_port_ctx_destroy,
+};
+
+/* The kernel devlink-port interface provides a vendor neutral and standard way
+ * of discovering host visible resources such as MAC address of interfaces from
+ * a program running on the NIC SoC side.
+ *
+ * However a fairly recent kernel version is required for it to work, so until
+ * this is widely available we provide this helper to retrieve the same
+ * information from the interim sysfs solution. */
+#ifndef OVSTEST
+static bool
+compat_get_host_pf_mac(const char *netdev_name, struct eth_addr *ea)
+{
+    char file_name[IFNAMSIZ + 35 + 1];
+    char buf[512];
+    ssize_t n;
+    int fd;
+
+    snprintf(file_name, sizeof(file_name), COMPAT_PF_CONFIG_FMT, netdev_name);
+    fd = open(file_name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        VLOG_WARN("%s: open failed (%s)",
+                  file_name, ovs_strerror(errno));
+        *ea = eth_addr_zero;
+        return false;
+    }
+    /* The whole file is small enough to be retrieved with a single read. */
+    n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n < 0) {
+        VLOG_WARN("%s: read failed (%s)",
+                  file_name, ovs_strerror(errno));
+        *ea = eth_addr_zero;
+        return false;
+    }
+    buf[n] = '\0';
+
+    for (char *line = buf; line && *line; ) {
+        char *next = strchr(line, '\n');
+
+        if (next) {
+            *next++ = '\0';
+        }
+        if (!strncmp(line, "MAC", 3)) {
+            /* point cp at start of MAC address after the ':' separator */
+            char *cp = strchr(line, ':');
+            if (!cp) {
+                break;
+            }
+            cp += strspn(cp + 1, " \t") + 1;
+            return eth_addr_from_string(cp, ea);
+        }
+        line = next;
+    }
+    return false;
+}
+
+/* Reads the contents of the sysfs file 'file_name' into 'buf', which is
+ * null terminated.  Returns the number of bytes read, or -1 on failure. */
+static ssize_t
+sysfs_read(const char *file_name, char *buf, size_t size)
+{
+    ssize_t n;
+    int fd;
+
+    fd = open(file_name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    n = read(fd, buf, size - 1);
+    close(fd);
+    if (n < 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+static bool
+snapshot_check_ifindex(uint32_t netdev_ifindex, const char *netdev_name)
+{
+    char name[IFNAMSIZ];
+
+    return if_indextoname(netdev_ifindex, name) && !strcmp(name, netdev_name);
+}
+
+static bool
+snapshot_check_device(const char *bus_name, const char *dev_name)
+{
+    char *path = xasprintf("/sys/bus/%s/devices/%s", bus_name, dev_name);
+    bool exists = !access(path, F_OK);
+
+    free(path);
+    return exists;
+}
+
+/* Retrieves the 'n' devlink ports of 'queries' with a single batch of
+ * requests.  The port entries refer to data owned by the returned batch,
+ * which the caller must destroy once done with them. */
+static struct nl_dl_batch *
+devlink_port_get_batch(struct devlink_port_query *queries, size_t n)
+{
+    struct nl_dl_batch *batch = nl_dl_batch_create();
+    size_t *idx = xmalloc(n * sizeof *idx);
+    int error;
+
+    for (size_t i = 0; i < n; i++) {
+        if (queries[i].port_index != UINT32_MAX) {
+            idx[i] = nl_dl_batch_add_port_get(batch, queries[i].bus_name,
+                                              queries[i].dev_name,
+                                              queries[i].port_index);
+        }
+    }
+    error = nl_dl_batch_run(batch);
+    for (size_t i = 0; i < n; i++) {
+        struct devlink_port_query *q = &queries[i];
+
+        if (q->port_index == UINT32_MAX) {
+            q->error = ENODEV;
+        } else {
+            q->error = error ? error
+                             : nl_dl_batch_get_port(batch, idx[i],
+                                                    &q->port_entry);
+        }
+    }
+    free(idx);
+    return batch;
+}
+
+static int
+devlink_port_function_set(const char *bus_name, const char *dev_name,
+                          uint32_t port_index,
+                          const struct dl_port_function *port_fn)
+{
+    return nl_dl_port_function_set(bus_name, dev_name, port_index, port_fn);
+}
+
+static int
+devlink_port_new(const char *bus_name, const char *dev_name,
+                 uint16_t pci_pf_number, uint32_t pci_sf_number,
+                 uint32_t controller_number, struct dl_port *port_entry,
+                 struct ofpbuf **bufp)
+{
+    return nl_dl_port_new(bus_name, dev_name, DEVLINK_PORT_FLAVOUR_PCI_SF,
+                          pci_pf_number, pci_sf_number, controller_number,
+                          port_entry, bufp);
+}
+
+static int
+devlink_port_del(const char *bus_name, const char *dev_name,
+                 uint32_t port_index)
+{
+    return nl_dl_port_del(bus_name, dev_name, port_index);
+}
+
+static int
+devlink_rate_get(const char *bus_name, const char *dev_name,
+                 uint32_t port_index, struct dl_rate *rate_entry,
+                 struct ofpbuf **bufp)
+{
+    return nl_dl_rate_get(bus_name, dev_name, port_index, NULL, rate_entry,
+                          bufp);
+}
+
+static int
+devlink_rate_set(const struct dl_rate *rate)
+{
+    return nl_dl_rate_set(rate);
+}
+
+static int
+devlink_rate_new(const struct dl_rate *rate)
+{
+    return nl_dl_rate_new(rate);
+}
+
+static int
+devlink_param_get(const char *bus_name, const char *dev_name,
+                  const char *name, struct dl_param *param_entry,
+                  struct ofpbuf **bufp)
+{
+    return nl_dl_param_get(bus_name, dev_name, name, param_entry, bufp);
+}
+
+static int
+devlink_param_set(const char *bus_name, const char *dev_name,
+                  const char *name, uint8_t type,
+                  const struct dl_param_value *value)
+{
+    return nl_dl_param_set(bus_name, dev_name, name, type, value);
+}
+#endif /* OVSTEST */
+
+#ifdef OVSTEST
+#include "tests/ovstest.h"
+
+static bool snapshot_check_ifindex_result = true;
+static const char *snapshot_missing_dev_name;
+static const struct dl_port *devlink_port_get_result;
+static size_t devlink_port_get_batch_calls;
+
+static struct nl_dl_batch *
+devlink_port_get_batch(struct devlink_port_query *queries, size_t n)
+{
+    devlink_port_get_batch_calls++;
+    for (size_t i = 0; i < n; i++) {
+        struct devlink_port_query *q = &queries[i];
+
+        if (!devlink_port_get_result
+            || devlink_port_get_result->index != q->port_index) {
+            q->error = ENODEV;
+        } else {
+            q->error = 0;
+            q->port_entry = *devlink_port_get_result;
+        }
+    }
+    return NULL;
+}
+
+static int devlink_port_function_set_error;
+static size_t devlink_port_function_set_calls;
+static struct dl_port_function devlink_port_function_set_last;
+/* Called while the transaction is in flight, 'port_table_mutex' is not
+ * held. */
+static void (*devlink_port_function_set_hook)(void);
+
+static int
+devlink_port_function_set(const char *bus_name OVS_UNUSED,
+                          const char *dev_name OVS_UNUSED,
+                          uint32_t port_index OVS_UNUSED,
+                          const struct dl_port_function *port_fn)
+{
+    devlink_port_function_set_calls++;
+    devlink_port_function_set_last = *port_fn;
+    if (devlink_port_function_set_hook) {
+        devlink_port_function_set_hook();
+    }
+    return devlink_port_function_set_error;
+}
+
+static int devlink_port_new_error;
+static const struct dl_port *devlink_port_new_result;
+static uint32_t devlink_port_new_last_sf_number;
+static uint32_t devlink_port_new_last_controller;
+
+static int
+devlink_port_new(const char *bus_name OVS_UNUSED,
+                 const char *dev_name OVS_UNUSED,
+                 uint16_t pci_pf_number OVS_UNUSED, uint32_t pci_sf_number,
+                 uint32_t controller_number, struct dl_port *port_entry,
+                 struct ofpbuf **bufp)
+{
+    *bufp = NULL;
+    devlink_port_new_last_sf_number = pci_sf_number;
+    devlink_port_new_last_controller = controller_number;
+    if (devlink_port_new_error) {
+        return devlink_port_new_error;
+    }
+    *port_entry = *devlink_port_new_result;
+    return 0;
+}
+
+static size_t devlink_port_del_calls;
+static uint32_t devlink_port_del_last_index;
+
+static int
+devlink_port_del(const char *bus_name OVS_UNUSED,
+                 const char *dev_name OVS_UNUSED, uint32_t port_index)
+{
+    devlink_port_del_calls++;
+    devlink_port_del_last_index = port_index;
+    return 0;
+}
+
+static const struct dl_rate *devlink_rate_get_result;
+static size_t devlink_rate_get_calls;
+
+static int
+devlink_rate_get(const char *bus_name OVS_UNUSED,
+                 const char *dev_name OVS_UNUSED,
+                 uint32_t port_index OVS_UNUSED, struct dl_rate *rate_entry,
+                 struct ofpbuf **bufp)
+{
+    *bufp = NULL;
+    devlink_rate_get_calls++;
+    if (!devlink_rate_get_result) {
+        return EOPNOTSUPP;
+    }
+    *rate_entry = *devlink_rate_get_result;
+    return 0;
+}
+
+static int devlink_rate_set_error;
+static size_t devlink_rate_set_calls;
+static struct dl_rate devlink_rate_set_last;
+/* Called while the transaction is in flight, 'port_table_mutex' is not
+ * held. */
+static void (*devlink_rate_set_hook)(void);
+
+static int
+devlink_rate_set(const struct dl_rate *rate)
+{
+    devlink_rate_set_calls++;
+    devlink_rate_set_last = *rate;
+    if (devlink_rate_set_hook) {
+        devlink_rate_set_hook();
+    }
+    return devlink_rate_set_error;
+}
+
+static int devlink_rate_new_error;
+static size_t devlink_rate_new_calls;
+
+static int
+devlink_rate_new(const struct dl_rate *rate OVS_UNUSED)
+{
+    devlink_rate_new_calls++;
+    return devlink_rate_new_error;
+}
+
+/* Emulated devlink parameter, absent if NULL.  Unless
+ * 'devlink_param_set_ignore' is set, a successful set updates it. */
+static struct dl_param *devlink_param_stub;
+static int devlink_param_set_error;
+static bool devlink_param_set_ignore;
+static size_t devlink_param_set_calls;
+static struct dl_param_value devlink_param_set_last;
+
+static int
+devlink_param_get(const char *bus_name OVS_UNUSED,
+                  const char *dev_name OVS_UNUSED,
+                  const char *name, struct dl_param *param_entry,
+                  struct ofpbuf **bufp)
+{
+    *bufp = NULL;
+    if (!devlink_param_stub || strcmp(name, devlink_param_stub->name)) {
+        return EINVAL;
+    }
+    *param_entry = *devlink_param_stub;
+    return 0;
+}
+
+static int
+devlink_param_set(const char *bus_name OVS_UNUSED,
+                  const char *dev_name OVS_UNUSED,
+                  const char *name OVS_UNUSED, uint8_t type OVS_UNUSED,
+                  const struct dl_param_value *value)
+{
+    devlink_param_set_calls++;
+    devlink_param_set_last = *value;
+    if (devlink_param_set_error) {
+        return devlink_param_set_error;
+    }
+    for (size_t i = 0; i < devlink_param_stub->n_values; i++) {
+        if (devlink_param_stub->values[i].cmode == value->cmode
+            && !devlink_param_set_ignore) {
+            devlink_param_stub->values[i] = *value;
+        }
+    }
+    return 0;
+}
+
+static bool
+snapshot_check_ifindex(uint32_t netdev_ifindex OVS_UNUSED,
+                       const char *netdev_name OVS_UNUSED)
+{
+    return snapshot_check_ifindex_result;
+}
+
+static bool
+snapshot_check_device(const char *bus_name OVS_UNUSED, const char *dev_name)
+{
+    return !snapshot_missing_dev_name
+           || strcmp(dev_name, snapshot_missing_dev_name);
+}
+
+static int compat_get_host_pf_mac_calls;
+static struct eth_addr compat_host_pf_mac = ETH_ADDR_C(00,53,00,00,00,51);
+
+/* Contents of the SR-IOV attributes of the PF at 0000:03:00.0, as the
+ * kernel renders them. */
+static const char *sysfs_sriov_offset = "2\n";
+static const char *sysfs_sriov_stride = "1\n";
+
+static ssize_t
+sysfs_read(const char *file_name, char *buf, size_t size)
+{
+    const char *prefix = "/sys/bus/pci/devices/0000:03:00.0/";
+    const char *contents;
+
+    if (strncmp(file_name, prefix, strlen(prefix))) {
+        return -1;
+    }
+    file_name += strlen(prefix);
+    if (!strcmp(file_name, "sriov_offset")) {
+        contents = sysfs_sriov_offset;
+    } else if (!strcmp(file_name, "sriov_stride")) {
+        contents = sysfs_sriov_stride;
+    } else {
+        return -1;
+    }
+    if (!contents) {
+        return -1;
+    }
+    ovs_strlcpy(buf, contents, size);
+    return strlen(buf);
+}
+
+static bool
+compat_get_host_pf_mac(const char *netdev_name, struct eth_addr *ea)
+{
+    compat_get_host_pf_mac_calls++;
+    ovs_assert(!strcmp(netdev_name, "p0"));
+    *ea = compat_host_pf_mac;
+    return true;
+}
+
+static struct port_node *
+_lookup_phy(struct port_table *tbl, const char *bus_name,
+            const char *dev_name, uint16_t flavour, uint32_t number)
+{
+    struct phy_node *phy;
+
+    phy = port_table_lookup_phy_bus_dev(tbl, bus_name, dev_name, flavour,
+                                        number);
+    return phy ? &phy->up : NULL;
+}
+
+static void
+_init_store(void)
+{
+    port_table = port_table_create();
+
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 10, "p0", 0,
+        UINT16_MAX, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PHYSICAL,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,00),
+        PORT_NODE_SOURCE_DUMP);
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 100, "p0hpf", UINT32_MAX,
+        0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_PF,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42),
+        PORT_NODE_SOURCE_DUMP);
+}
+
+static void
+_destroy_store(void)
+{
+    port_table_destroy(port_table);
+}
+
+static void
+test_phy_store(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct port_node *pn;
+
+    _init_store();
+
+    pn = _lookup_phy(port_table, "pci", "0000:03:00.0",
+                     DEVLINK_PORT_FLAVOUR_PHYSICAL, 0);
+    ovs_assert(pn);
+    ovs_assert(pn->netdev_ifindex == 10);
+    ovs_assert(!strcmp(pn->netdev_name, "p0"));
+    ovs_assert(
+        eth_addr_equals(pn->mac,
+                        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,00)));
+    ovs_assert(pn->flavour == DEVLINK_PORT_FLAVOUR_PHYSICAL);
+    ovs_assert(pn->number == 0);
+
+    ovs_assert(pn == port_table_lookup_ifindex(port_table, 10));
+
+    pn = _lookup_phy(port_table, "pci", "0000:03:00.0",
+                     DEVLINK_PORT_FLAVOUR_PCI_PF, 0);
+    ovs_assert(pn);
+    ovs_assert(pn->netdev_ifindex == 100);
+    ovs_assert(!strcmp(pn->netdev_name, "p0hpf"));
+    ovs_assert(
+        eth_addr_equals(pn->mac,
+                        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42)));
+    ovs_assert(pn == port_table_lookup_ifindex(port_table, 100));
+
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
+                            UINT32_MAX, 0, UINT16_MAX,
+                            DEVLINK_PORT_FLAVOUR_PCI_PF);
+
+    pn = _lookup_phy(port_table, "pci", "0000:03:00.0",
+                     DEVLINK_PORT_FLAVOUR_PCI_PF, 0);
+    ovs_assert(!pn);
+
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
+                            0, UINT16_MAX, UINT16_MAX,
+                            DEVLINK_PORT_FLAVOUR_PHYSICAL);
+
+    pn = _lookup_phy(port_table, "pci", "0000:03:00.0",
+                     DEVLINK_PORT_FLAVOUR_PHYSICAL, 0);
+    ovs_assert(!pn);
+
+    /* confirm that we would not misbehave on attempt to delete non-existing
+     * entries. */
+    port_table_delete_entry(port_table, "nonexistent", "device",
+                            UINT32_MAX, 0, UINT16_MAX,
+                            DEVLINK_PORT_FLAVOUR_PCI_PF);
+    port_table_delete_entry(port_table, "nonexistent", "device",
+                            0, UINT16_MAX, UINT16_MAX,
+                            DEVLINK_PORT_FLAVOUR_PHYSICAL);
+
+    _destroy_store();
+}
+
+static void
+test_port_store(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct port_node *pn;
+
+    _init_store();
+
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 1000, "pf0vf0", UINT32_MAX,
+        0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+        PORT_NODE_SOURCE_RUNTIME);
+
+    pn = port_table_lookup_ifindex(port_table, 1000);
+
+    ovs_assert(pn);
+    ovs_assert(pn->netdev_ifindex == 1000);
+    ovs_assert(!strcmp(pn->netdev_name, "pf0vf0"));
+    ovs_assert(
+        eth_addr_equals(pn->mac,
+                        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00)));
+    ovs_assert(pn->flavour == DEVLINK_PORT_FLAVOUR_PCI_VF);
+    ovs_assert(pn->number == 0);
+    ovs_assert(pn->port_node_source == PORT_NODE_SOURCE_RUNTIME);
+
+    ovs_assert(!strcmp(function_node_cast(pn)->pf->up.netdev_name,
+                       "p0hpf"));
+
+    pn = port_table_lookup_pf_mac_vf(
+        port_table,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42),
+        0);
+
+    ovs_assert(pn);
+    ovs_assert(pn->netdev_ifindex == 1000);
+    ovs_assert(!strcmp(pn->netdev_name, "pf0vf0"));
+    ovs_assert(
+        eth_addr_equals(pn->mac,
+                        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00)));
+
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0", UINT32_MAX,
+                            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF);
+
+    pn = port_table_lookup_ifindex(port_table, 1000);
+    ovs_assert(!pn);
+
+    pn = port_table_lookup_pf_mac_vf(
+        port_table,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42),
+        0);
+    ovs_assert(!pn);
+
+    /* confirm that we would not misbehave on attempt to delete non-existing
+     * entries. */
+    port_table_delete_entry(port_table, "non", "existing", UINT32_MAX,
+                            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF);
+
+    _destroy_store();
+}
+
+static void
+test_port_node_rename_expected(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct port_node *pn;
+
+    _init_store();
+
+    pn = port_table_lookup_ifindex(port_table, 100);
+    ovs_assert(port_node_rename_expected(pn) == false);
+
+    pn = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "eth0", UINT32_MAX,
+            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+            PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(port_node_rename_expected(pn) == true);
+
+    _destroy_store();
+}
+
+static void
+test_port_table_rename_wait(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct port_node *pn0, *pn1;
+    long long int start;
+
+    _init_store();
+    memset(&rename_wait_stats, 0, sizeof rename_wait_stats);
+
+    pn0 = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "eth0", UINT32_MAX,
+            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+            PORT_NODE_SOURCE_RUNTIME);
+    pn1 = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1001, "eth1", UINT32_MAX,
+            0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,01),
+            PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(ovs_list_size(&rename_wait_list) == 2);
+    start = pn0->rename_wait_start;
+
+    /* Nothing expires before the deadline. */
+    ovs_assert(!port_table_rename_wait_run(start, LLONG_MAX));
+    ovs_assert(port_node_rename_expected(pn0));
+
+    /* A rename ends the wait. */
+    port_node_update(pn0, "pf0vf0");
+    ovs_assert(!port_node_rename_expected(pn0));
+    ovs_assert(ovs_list_size(&rename_wait_list) == 1);
+    ovs_assert(rename_wait_stats.n_renamed == 1);
+
+    /* On expiry the port is refreshed from the kernel. */
+    struct dl_port dl_port = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .index = 1,
+        .netdev_ifindex = 1001,
+        .netdev_name = "pf0vf1",
+        .number = UINT32_MAX,
+        .pci_pf_number = 0,
+        .pci_vf_number = 1,
+        .flavour = DEVLINK_PORT_FLAVOUR_PCI_VF,
+        .function.eth_addr = ETH_ADDR_C(00,53,00,00,10,01),
+    };
+    pn1->dl_port_index = 1;
+    devlink_port_get_result = &dl_port;
+    devlink_port_get_batch_calls = 0;
+    ovs_assert(port_table_rename_wait_run(
+                    pn1->rename_wait_start + RENAME_WAIT_TIMEOUT_MSEC,
+                    LLONG_MAX));
+    ovs_assert(devlink_port_get_batch_calls == 1);
+    ovs_assert(!port_node_rename_expected(pn1));
+    ovs_assert(!strcmp(pn1->netdev_name, "pf0vf1"));
+    ovs_assert(ovs_list_is_empty(&rename_wait_list));
+    ovs_assert(rename_wait_stats.n_expired == 1);
+    ovs_assert(rename_wait_stats.n_resolved == 1);
+    ovs_assert(rename_wait_stats.n_renamed == 1);
+    devlink_port_get_result = NULL;
+
+    /* On expiry without a new name, the current name is accepted. */
+    pn0 = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1002, "eth2", UINT32_MAX,
+            0, 2, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,02),
+            PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(port_table_rename_wait_run(
+                    pn0->rename_wait_start + RENAME_WAIT_TIMEOUT_MSEC,
+                    LLONG_MAX));
+    ovs_assert(!port_node_rename_expected(pn0));
+    ovs_assert(!strcmp(pn0->netdev_name, "eth2"));
+    ovs_assert(rename_wait_stats.n_expired == 2);
+    ovs_assert(rename_wait_stats.n_resolved == 1);
+
+    /* Ports whose waits expire together are refreshed with one batch. */
+    devlink_port_get_batch_calls = 0;
+    for (uint16_t i = 0; i < RENAME_WAIT_BATCH_MAX + 1; i++) {
+        char name[IFNAMSIZ];
+
+        snprintf(name, sizeof name, "eth%d", 100 + i);
+        port_table_update_entry(
+                port_table, "pci", "0000:03:00.0", 1100 + i, name,
+                UINT32_MAX, 0, 100 + i, DEVLINK_PORT_FLAVOUR_PCI_VF,
+                (struct eth_addr) ETH_ADDR_C(00,53,00,00,11,00),
+                PORT_NODE_SOURCE_RUNTIME);
+    }
+    pn0 = CONTAINER_OF(ovs_list_back(&rename_wait_list),
+                       struct port_node, rename_wait_node);
+    ovs_assert(port_table_rename_wait_run(
+                    pn0->rename_wait_start + RENAME_WAIT_TIMEOUT_MSEC,
+                    LLONG_MAX));
+    ovs_assert(ovs_list_is_empty(&rename_wait_list));
+    ovs_assert(devlink_port_get_batch_calls == 2);
+    ovs_assert(rename_wait_stats.n_expired == 2 + RENAME_WAIT_BATCH_MAX + 1);
+
+    /* Removing a port that is waiting removes it from the wait list. */
+    pn0 = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1003, "eth3", UINT32_MAX,
+            0, 3, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,03),
+            PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(ovs_list_size(&rename_wait_list) == 1);
+    _destroy_store();
+    ovs_assert(ovs_list_is_empty(&rename_wait_list));
+}
+
+static void
+test_port_table_rename_buffer(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct port_node *pn;
+
+    _init_store();
+
+    /* Rename reported before the port. */
+    rename_buffer_record(1000, "pf0vf0", true);
+    pn = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "eth0", UINT32_MAX,
+            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+            PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(!strcmp(pn->netdev_name, "pf0vf0"));
+    ovs_assert(!port_node_rename_expected(pn));
+    ovs_assert(ovs_list_is_empty(&pn->rename_wait_node));
+    ovs_assert(!rename_buffer_lookup(1000));
+
+    /* Port reported with the post-rename name. */
+    rename_buffer_record(1001, "pf0vf1", true);
+    pn = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1001, "pf0vf1", UINT32_MAX,
+            0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,01),
+            PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(!strcmp(pn->netdev_name, "pf0vf1"));
+    ovs_assert(!port_node_rename_expected(pn));
+
+    /* Link events are only considered a rename when the name changes. */
+    rename_buffer_record(1002, "eth2", false);
+    ovs_assert(!rename_buffer_lookup(1002)->renamed);
+    rename_buffer_record(1002, "pf0vf2", false);
+    ovs_assert(rename_buffer_lookup(1002)->renamed);
+    rename_buffer_record(1003, "eth3", false);
+    pn = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1003, "eth3", UINT32_MAX,
+            0, 3, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,03),
+            PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(port_node_rename_expected(pn));
+
+    /* Entries expire. */
+    rename_buffer_expire(time_msec() + RENAME_BUFFER_TTL_MSEC);
+    ovs_assert(!rename_buffer_lookup(1002));
+    ovs_assert(hmap_is_empty(&rename_buffer));
+
+    /* The number of entries is capped, evicting the oldest. */
+    for (uint32_t i = 0; i < RENAME_BUFFER_MAX + 1; i++) {
+        rename_buffer_record(2000 + i, "eth", true);
+    }
+    ovs_assert(hmap_count(&rename_buffer) == RENAME_BUFFER_MAX);
+    ovs_assert(!rename_buffer_lookup(2000));
+    ovs_assert(rename_buffer_lookup(2001));
+    rename_buffer_clear();
+    ovs_assert(ovs_list_is_empty(&rename_buffer_list));
+
+    _destroy_store();
+}
+
+static void
+test_rtnl_monitor_cb(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+#ifdef RENAME_TRACKING_RTNL
+    struct rtnetlink_change change = {
+        .nlmsg_type = RTM_NEWLINK,
+        .if_index = 1000,
+        .ifname = "pf0vf0",
+    };
+    struct port_node *pn;
+
+    _init_store();
+    pn = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "eth0", UINT32_MAX,
+            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+            PORT_NODE_SOURCE_RUNTIME);
+    rtnl_monitor_changed = false;
+
+    /* Link events that do not change the name are ignored. */
+    change.ifname = "eth0";
+    rtnl_monitor_cb(&change, NULL);
+    ovs_assert(!rtnl_monitor_changed);
+    ovs_assert(port_node_rename_expected(pn));
+
+    /* So are other messages, and messages without a name. */
+    change.nlmsg_type = RTM_DELLINK;
+    change.ifname = "pf0vf0";
+    rtnl_monitor_cb(&change, NULL);
+    change.nlmsg_type = RTM_NEWLINK;
+    change.ifname = NULL;
+    rtnl_monitor_cb(&change, NULL);
+    ovs_assert(!rtnl_monitor_changed);
+    ovs_assert(!strcmp(pn->netdev_name, "eth0"));
+
+    /* A rename of a known port is applied. */
+    change.ifname = "pf0vf0";
+    rtnl_monitor_cb(&change, NULL);
+    ovs_assert(rtnl_monitor_changed);
+    ovs_assert(!strcmp(pn->netdev_name, "pf0vf0"));
+    ovs_assert(!port_node_rename_expected(pn));
+    ovs_assert(rtnl_monitor_run());
+    ovs_assert(!rtnl_monitor_changed);
+
+    /* Names of ports not in the table yet are buffered. */
+    change.if_index = 1001;
+    change.ifname = "pf0vf1";
+    rtnl_monitor_cb(&change, NULL);
+    ovs_assert(!rtnl_monitor_changed);
+    ovs_assert(rename_buffer_lookup(1001));
+    ovs_assert(!rename_buffer_lookup(1001)->renamed);
+    rename_buffer_clear();
+
+    _destroy_store();
+#endif /* RENAME_TRACKING_RTNL */
+}
+
+static void
+test_monitor_thread(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    ovs_mutex_lock(&port_table_mutex);
+
+    /* The thread is only created once enabled. */
+    monitor_thread_set_active(false);
+    ovs_assert(!monitor_thread_created);
+
+    /* Changes drained by the main thread are remembered across drains. */
+    monitor_note_changes(true, false);
+#ifdef RENAME_TRACKING
+    ovs_assert(!monitor_take_changes());
+    monitor_note_changes(false, true);
+#endif /* RENAME_TRACKING */
+    ovs_assert(monitor_take_changes());
+    ovs_assert(!monitor_take_changes());
+
+    /* Changes made by the thread wake up the main loop through the seq.  The
+     * thread is left inactive, so that we can play its part. */
+    monitor_thread_create();
+    ovs_mutex_unlock(&port_table_mutex);
+    ovs_assert(!monitor_thread_run());
+
+    ovs_mutex_lock(&port_table_mutex);
+    monitor_note_changes(true, false);
+    ovs_mutex_unlock(&port_table_mutex);
+    seq_change(monitor_seq);
+    ovs_assert(seq_read(monitor_seq) != monitor_seqno);
+#ifdef RENAME_TRACKING
+    ovs_assert(!monitor_thread_run());
+    ovs_assert(seq_read(monitor_seq) == monitor_seqno);
+
+    ovs_mutex_lock(&port_table_mutex);
+    monitor_note_changes(false, true);
+    ovs_mutex_unlock(&port_table_mutex);
+    seq_change(monitor_seq);
+#endif /* RENAME_TRACKING */
+    ovs_assert(monitor_thread_run());
+    ovs_assert(seq_read(monitor_seq) == monitor_seqno);
+    ovs_assert(!monitor_thread_run());
+
+    monitor_thread_join();
+    ovs_assert(!monitor_thread_created);
+}
+
+/* Runs the classic BPF program 'code' against the 'len' bytes of 'pkt' the
+ * way the kernel runs a socket filter, for the subset of instructions our
+ * filters use, and returns the number of bytes to keep. */
+static uint32_t
+_bpf_run(const struct sock_filter *code, size_t n_code,
+         const uint8_t *pkt, size_t len)
+{
+    uint32_t a = 0;
+
+    for (size_t pc = 0; pc < n_code; pc++) {
+        const struct sock_filter *insn = &code[pc];
+
+        switch (insn->code) {
+        case BPF_LD | BPF_B | BPF_ABS:
+            if (insn->k >= len) {
+                return 0;
+            }
+            a = pkt[insn->k];
+            break;
+        case BPF_LD | BPF_W | BPF_ABS:
+            if (len < 4 || insn->k > len - 4) {
+                return 0;
+            }
+            a = (uint32_t) pkt[insn->k] << 24 | pkt[insn->k + 1] << 16
+                | pkt[insn->k + 2] << 8 | pkt[insn->k + 3];
+            break;
+        case BPF_JMP | BPF_JEQ | BPF_K:
+            pc += a == insn->k ? insn->jt : insn->jf;
+            break;
+        case BPF_RET | BPF_K:
+            return insn->k;
+        default:
+            OVS_NOT_REACHED();
+        }
+    }
+    OVS_NOT_REACHED();
+}
+
+static uint32_t
+_devlink_filter_run(uint8_t cmd, size_t len)
+{
+    uint8_t msg[NLMSG_HDRLEN + GENL_HDRLEN];
+
+    memset(msg, 0, sizeof msg);
+    msg[NLMSG_HDRLEN + offsetof(struct genlmsghdr, cmd)] = cmd;
+    return _bpf_run(devlink_monitor_filter,
+                    ARRAY_SIZE(devlink_monitor_filter), msg, len);
+}
+
+#ifdef RENAME_TRACKING_UDEV
+static uint32_t
+_udev_filter_run(const char *msg)
+{
+    return _bpf_run(udev_monitor_filter, ARRAY_SIZE(udev_monitor_filter),
+                    (const uint8_t *) msg, strlen(msg));
+}
+#endif /* RENAME_TRACKING_UDEV */
+
+static void
+test_monitor_filter(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    size_t len = NLMSG_HDRLEN + GENL_HDRLEN;
+
+    /* Port notifications pass, other devlink notifications do not. */
+    ovs_assert(_devlink_filter_run(DEVLINK_CMD_PORT_NEW, len));
+    ovs_assert(_devlink_filter_run(DEVLINK_CMD_PORT_DEL, len));
+    ovs_assert(!_devlink_filter_run(DEVLINK_CMD_PORT_SET, len));
+    ovs_assert(!_devlink_filter_run(DEVLINK_CMD_PARAM_NEW, len));
+    ovs_assert(!_devlink_filter_run(DEVLINK_CMD_NEW, len));
+    /* A message too short to hold the command is dropped. */
+    ovs_assert(!_devlink_filter_run(DEVLINK_CMD_PORT_NEW, NLMSG_HDRLEN));
+
+#ifdef RENAME_TRACKING_UDEV
+    /* Only "move" uevents pass. */
+    ovs_assert(_udev_filter_run("move@/devices/virtual/net/eth0"));
+    ovs_assert(!_udev_filter_run("add@/devices/virtual/net/eth0"));
+    ovs_assert(!_udev_filter_run("remove@/devices/virtual/net/eth0"));
+    ovs_assert(!_udev_filter_run("moved@/devices/virtual/net/eth0"));
+    ovs_assert(!_udev_filter_run("evom@/devices/virtual/net/eth0"));
+    ovs_assert(!_udev_filter_run("move"));
+    ovs_assert(!_udev_filter_run("mov"));
+#endif /* RENAME_TRACKING_UDEV */
+}
+
+static void
+test_port_table_pending(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct eth_addr pf_mac = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,43);
+    struct port_node *pn;
+
+    _init_store();
+
+    /* Functions of an unknown PF are parked. */
+    for (uint16_t i = 0; i < 3; i++) {
+        pn = port_table_update_entry(
+                port_table, "pci", "0000:03:00.1", 2000 + i, "eth", UINT32_MAX,
+                1, i, DEVLINK_PORT_FLAVOUR_PCI_VF,
+                (struct eth_addr) ETH_ADDR_C(00,53,00,00,20,00),
+                PORT_NODE_SOURCE_DUMP);
+        ovs_assert(!pn);
+    }
+    ovs_assert(!port_table_lookup_ifindex(port_table, 2000));
+    ovs_assert(hmap_count(&port_table->pending_table) == 1);
+
+    /* A repeated update replaces the parked record. */
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.1", 2000, "pf1vf0", UINT32_MAX,
+            1, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,20,00),
+            PORT_NODE_SOURCE_DUMP);
+
+    /* A parked function can be deleted. */
+    port_table_delete_entry(port_table, "pci", "0000:03:00.1",
+                            UINT32_MAX, 1, 2, DEVLINK_PORT_FLAVOUR_PCI_VF);
+
+    /* Functions of another PF number on the same device are not affected. */
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.1", 3000, "pf2vf0", UINT32_MAX,
+            2, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,30,00),
+            PORT_NODE_SOURCE_DUMP);
+    ovs_assert(hmap_count(&port_table->pending_table) == 2);
+
+    /* The PF arrives and the functions are attached. */
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.1", 101, "p1hpf", UINT32_MAX,
+        1, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_PF, pf_mac,
+        PORT_NODE_SOURCE_DUMP);
+    ovs_assert(hmap_count(&port_table->pending_table) == 1);
+
+    pn = port_table_lookup_pf_mac_vf(port_table, pf_mac, 0);
+    ovs_assert(pn);
+    ovs_assert(pn->netdev_ifindex == 2000);
+    ovs_assert(!strcmp(pn->netdev_name, "pf1vf0"));
+    pn = port_table_lookup_pf_mac_vf(port_table, pf_mac, 1);
+    ovs_assert(pn);
+    ovs_assert(pn->netdev_ifindex == 2001);
+    ovs_assert(!port_table_lookup_pf_mac_vf(port_table, pf_mac, 2));
+    ovs_assert(!port_table_lookup_ifindex(port_table, 3000));
+
+    /* Functions whose PF does not appear are eventually dropped. */
+    port_table_pending_run(port_table, time_msec());
+    ovs_assert(hmap_count(&port_table->pending_table) == 1);
+    port_table_pending_run(port_table, time_msec() + PENDING_TIMEOUT_MSEC);
+    ovs_assert(hmap_is_empty(&port_table->pending_table));
+
+    /* Remaining parked functions are freed with the table. */
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.1", 3000, "pf2vf0", UINT32_MAX,
+            2, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,30,00),
+            PORT_NODE_SOURCE_DUMP);
+    _destroy_store();
+}
+
+static void
+test_port_table_pf_mac_change(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct eth_addr old_mac = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42);
+    struct eth_addr new_mac = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,44);
+    struct port_node *pf, *pn;
+
+    _init_store();
+
+    for (uint16_t i = 0; i < 2; i++) {
+        port_table_update_entry(
+                port_table, "pci", "0000:03:00.0", 1000 + i, "pf0vf",
+                UINT32_MAX, 0, i, DEVLINK_PORT_FLAVOUR_PCI_VF,
+                (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+                PORT_NODE_SOURCE_DUMP);
+    }
+    pf = port_table_lookup_ifindex(port_table, 100);
+    ovs_assert(ovs_list_size(&phy_node_cast(pf)->children) == 2);
+
+    /* The functions are re-indexed under the new PF MAC. */
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 100, "p0hpf", UINT32_MAX,
+        0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_PF, new_mac,
+        PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(eth_addr_equals(pf->mac, new_mac));
+    ovs_assert(!port_table_lookup_pf_mac_vf(port_table, old_mac, 0));
+    ovs_assert(!port_table_lookup_pf_mac_vf(port_table, old_mac, 1));
+    pn = port_table_lookup_pf_mac_vf(port_table, new_mac, 0);
+    ovs_assert(pn && pn->netdev_ifindex == 1000);
+    pn = port_table_lookup_pf_mac_vf(port_table, new_mac, 1);
+    ovs_assert(pn && pn->netdev_ifindex == 1001);
+
+    /* Removing a function removes it from the list of its PF. */
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
+                            UINT32_MAX, 0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF);
+    ovs_assert(ovs_list_size(&phy_node_cast(pf)->children) == 1);
+
+    /* Functions of a removed PF are parked until it reappears, and do not
+     * wait for a rename again when re-attached. */
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1002, "eth2", UINT32_MAX,
+            0, 2, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,02),
+            PORT_NODE_SOURCE_RUNTIME);
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
+                            UINT32_MAX, 0, UINT16_MAX,
+                            DEVLINK_PORT_FLAVOUR_PCI_PF);
+    ovs_assert(!port_table_lookup_ifindex(port_table, 1000));
+    ovs_assert(hmap_count(&port_table->pending_table) == 1);
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 100, "p0hpf", UINT32_MAX,
+        0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_PF, old_mac,
+        PORT_NODE_SOURCE_RUNTIME);
+    pn = port_table_lookup_pf_mac_vf(port_table, old_mac, 0);
+    ovs_assert(pn && pn->netdev_ifindex == 1000);
+    pn = port_table_lookup_pf_mac_vf(port_table, old_mac, 2);
+    ovs_assert(pn && pn->netdev_ifindex == 1002);
+    ovs_assert(!port_node_rename_expected(pn));
+    ovs_assert(ovs_list_is_empty(&rename_wait_list));
+    ovs_assert(hmap_is_empty(&port_table->pending_table));
+
+    _destroy_store();
+}
+
+static atomic_bool lockless_reader_stop = ATOMIC_VAR_INIT(false);
+
+/* Looks up VF 0 of PF 0 of the store the way a thread that does not hold
+ * 'port_table_mutex' would, checking that the keys it sees are consistent
+ * with the key it looked up by. */
+static void *
+lockless_reader_main(void *arg OVS_UNUSED)
+{
+    struct eth_addr mac_a = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42);
+    struct eth_addr mac_b = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,44);
+
+    for (;;) {
+        const struct port_keys *keys;
+        struct port_node *pn;
+        bool stop;
+
+        atomic_read(&lockless_reader_stop, &stop);
+        if (stop) {
+            break;
+        }
+        pn = port_table_lookup_ifindex(port_table, 1000);
+        if (pn) {
+            keys = port_node_keys(pn);
+            ovs_assert(keys->netdev_ifindex == 1000);
+            ovs_assert(!strcmp(keys->netdev_name, "pf0vf0")
+                       || !strcmp(keys->netdev_name, "eth0"));
+        }
+        pn = port_table_lookup_pf_mac_vf(port_table, mac_a, 0);
+        if (pn) {
+            ovs_assert(eth_addr_equals(port_node_keys(pn)->pf_mac, mac_a));
+        }
+        pn = port_table_lookup_pf_mac_vf(port_table, mac_b, 0);
+        if (pn) {
+            ovs_assert(eth_addr_equals(port_node_keys(pn)->pf_mac, mac_b));
+        }
+        ovsrcu_quiesce();
+    }
+    return NULL;
+}
+
+static void
+test_port_table_lockless_lookup(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct eth_addr mac_a = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42);
+    struct eth_addr mac_b = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,44);
+    const struct port_keys *keys;
+    struct port_node *pn;
+    pthread_t reader;
+
+    _init_store();
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "eth0",
+            UINT32_MAX, 0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+            PORT_NODE_SOURCE_DUMP);
+
+    /* The keys follow renames and re-keying of the node. */
+    pn = port_table_lookup_ifindex(port_table, 1000);
+    keys = port_node_keys(pn);
+    ovs_assert(!strcmp(keys->netdev_name, "eth0"));
+    ovs_assert(eth_addr_equals(keys->pf_mac, mac_a));
+
+    /* Rename the VF and flip the MAC of its PF back and forth while another
+     * thread looks it up without taking the mutex. */
+    reader = ovs_thread_create("lockless_reader", lockless_reader_main,
+                               NULL);
+    for (int i = 0; i < 10000; i++) {
+        ovs_mutex_lock(&port_table_mutex);
+        port_table_update_entry(
+                port_table, "pci", "0000:03:00.0", 1000,
+                i % 2 ? "eth0" : "pf0vf0", UINT32_MAX, 0, 0,
+                DEVLINK_PORT_FLAVOUR_PCI_VF,
+                (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+                PORT_NODE_SOURCE_DUMP);
+        port_table_update_entry(
+                port_table, "pci", "0000:03:00.0", 100, "p0hpf",
+                UINT32_MAX, 0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_PF,
+                i % 2 ? mac_a : mac_b, PORT_NODE_SOURCE_DUMP);
+        ovs_mutex_unlock(&port_table_mutex);
+        ovsrcu_quiesce();
+    }
+    atomic_store(&lockless_reader_stop, true);
+    xpthread_join(reader, NULL);
+
+    pn = port_table_lookup_pf_mac_vf(port_table, mac_b, 0);
+    keys = port_node_keys(pn);
+    ovs_assert(keys->netdev_ifindex == 1000);
+    ovs_assert(!strcmp(keys->netdev_name, "pf0vf0"));
+    ovs_assert(eth_addr_equals(keys->pf_mac, mac_b));
+
+    _destroy_store();
+}
+
+static void
+test_port_table_function_mac(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct eth_addr mac0 = (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00);
+    struct eth_addr mac1 = (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,01);
+    struct eth_addr mac2 = (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,02);
+    struct port_node *pn;
+
+    _init_store();
+
+    for (uint16_t i = 0; i < 2; i++) {
+        port_table_update_entry(
+                port_table, "pci", "0000:03:00.0", 1000 + i, "pf0vf",
+                UINT32_MAX, 0, i, DEVLINK_PORT_FLAVOUR_PCI_VF,
+                i ? mac1 : mac0, PORT_NODE_SOURCE_DUMP);
+    }
+    pn = port_table_lookup_function_mac(port_table, mac0);
+    ovs_assert(pn && pn->netdev_ifindex == 1000);
+    pn = port_table_lookup_function_mac(port_table, mac1);
+    ovs_assert(pn && pn->netdev_ifindex == 1001);
+    ovs_assert(!port_table_lookup_function_mac(port_table, mac2));
+
+    /* PHYSICAL and PF ports are not indexed by MAC. */
+    ovs_assert(!port_table_lookup_function_mac(
+                    port_table,
+                    (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42)));
+
+    /* The function MAC may be changed by the host. */
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1001, "pf0vf",
+            UINT32_MAX, 0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            mac2, PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(!port_table_lookup_function_mac(port_table, mac1));
+    pn = port_table_lookup_function_mac(port_table, mac2);
+    ovs_assert(pn && pn->netdev_ifindex == 1001);
+
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
+                            UINT32_MAX, 0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF);
+    ovs_assert(!port_table_lookup_function_mac(port_table, mac2));
+    ovs_assert(port_table_lookup_function_mac(port_table, mac0));
+
+    /* Functions without a MAC are not indexed, neither while being set
+     * up nor after the MAC is cleared. */
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1002, "pf0vf",
+            UINT32_MAX, 0, 2, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            eth_addr_zero, PORT_NODE_SOURCE_DUMP);
+    ovs_assert(cmap_count(&port_table->function_mac_table) == 1);
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1002, "pf0vf",
+            UINT32_MAX, 0, 2, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            mac2, PORT_NODE_SOURCE_DUMP);
+    pn = port_table_lookup_function_mac(port_table, mac2);
+    ovs_assert(pn && pn->netdev_ifindex == 1002);
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1002, "pf0vf",
+            UINT32_MAX, 0, 2, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            eth_addr_zero, PORT_NODE_SOURCE_DUMP);
+    ovs_assert(!port_table_lookup_function_mac(port_table, mac2));
+    ovs_assert(cmap_count(&port_table->function_mac_table) == 1);
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
+                            UINT32_MAX, 0, 2, DEVLINK_PORT_FLAVOUR_PCI_VF);
+    ovs_assert(cmap_count(&port_table->function_mac_table) == 1);
+
+    _destroy_store();
+}
+
+/* Removes VF 0 of the PF of _init_store() as the monitor thread would. */
+static void
+_delete_vf0(void)
+{
+    ovs_mutex_lock(&port_table_mutex);
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
+                            UINT32_MAX, 0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF);
+    ovs_mutex_unlock(&port_table_mutex);
+}
+
+static int
+_sf_pool_claim(struct phy_node *pf, struct eth_addr mac,
+               struct port_node **pnp)
+{
+    int error;
+
+    ovs_mutex_lock(&port_table_mutex);
+    error = port_table_sf_pool_claim(port_table, pf, mac, pnp);
+    ovs_mutex_unlock(&port_table_mutex);
+    return error;
+}
+
+static void
+test_port_table_set_function_mac(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct eth_addr mac0 = (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00);
+    struct eth_addr mac1 = (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,01);
+    struct port_node *pf, *pn;
+
+    _init_store();
+
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "pf0vf0",
+            UINT32_MAX, 0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            mac0, PORT_NODE_SOURCE_DUMP);
+    pn = port_table_lookup_function_mac(port_table, mac0);
+    ovs_assert(pn);
+    ovs_mutex_lock(&port_table_mutex);
+
+    /* Nothing to do when the MAC is already in place. */
+    ovs_assert(!port_table_set_function_mac(port_table, &pn, mac0));
+    ovs_assert(devlink_port_function_set_calls == 0);
+
+    /* The devlink port index is required to address the port. */
+    ovs_assert(port_table_set_function_mac(port_table, &pn, mac1) == EAGAIN);
+    ovs_assert(devlink_port_function_set_calls == 0);
+    pn->dl_port_index = 1;
+
+    /* A failed request leaves the table untouched. */
+    devlink_port_function_set_error = EBUSY;
+    ovs_assert(port_table_set_function_mac(port_table, &pn, mac1) == EBUSY);
+    ovs_assert(devlink_port_function_set_calls == 1);
+    ovs_assert(port_table_lookup_function_mac(port_table, mac0) == pn);
+    ovs_assert(!port_table_lookup_function_mac(port_table, mac1));
+    devlink_port_function_set_error = 0;
+
+    /* Only the MAC is changed, the state of the function is left alone. */
+    ovs_assert(!port_table_set_function_mac(port_table, &pn, mac1));
+    ovs_assert(devlink_port_function_set_calls == 2);
+    ovs_assert(eth_addr_equals(devlink_port_function_set_last.eth_addr,
+                               mac1));
+    ovs_assert(devlink_port_function_set_last.state == UINT8_MAX);
+    ovs_assert(!port_table_lookup_function_mac(port_table, mac0));
+    ovs_assert(port_table_lookup_function_mac(port_table, mac1) == pn);
+
+    /* The mutex is released during the transaction, a port removed in the
+     * meantime is not touched. */
+    devlink_port_function_set_hook = _delete_vf0;
+    ovs_assert(port_table_set_function_mac(port_table, &pn, mac0) == ENODEV);
+    ovs_assert(!pn);
+    ovs_assert(devlink_port_function_set_calls == 3);
+    ovs_assert(!port_table_lookup_function_mac(port_table, mac0));
+    devlink_port_function_set_hook = NULL;
+
+    /* PF representors have no function MAC to program. */
+    pf = _lookup_phy(port_table, "pci", "0000:03:00.0",
+                     DEVLINK_PORT_FLAVOUR_PCI_PF, 0);
+    ovs_assert(port_table_set_function_mac(port_table, &pf, mac0) == EINVAL);
+    ovs_assert(devlink_port_function_set_calls == 3);
+
+    ovs_mutex_unlock(&port_table_mutex);
+    devlink_port_function_set_calls = 0;
+    _destroy_store();
+}
+
+static void
+test_port_table_sf(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct eth_addr pf_mac = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42);
+    struct eth_addr pf_mac2 = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,43);
+    struct port_node *vf, *sf;
+    struct smap iface_options;
+
+    _init_store();
+
+    /* VF and SF numbers are separate number spaces. */
+    vf = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "pf0vf1", UINT32_MAX,
+            0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+            PORT_NODE_SOURCE_DUMP);
+    sf = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 2000, "pf0sf1", 1,
+            0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_SF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,20,00),
+            PORT_NODE_SOURCE_DUMP);
+    ovs_assert(vf && sf && vf != sf);
+    ovs_assert(port_table_lookup_pf_mac_vf(port_table, pf_mac, 1) == vf);
+    ovs_assert(port_table_lookup_pf_mac_sf(port_table, pf_mac, 1) == sf);
+    ovs_assert(!port_table_lookup_pf_mac_sf(port_table, pf_mac, 0));
+    ovs_assert(port_table_lookup_function_mac(
+                   port_table,
+                   (struct eth_addr) ETH_ADDR_C(00,53,00,00,20,00)) == sf);
+
+    /* SF numbers are 32 bits wide. */
+    ovs_assert(port_table_update_entry(
+                   port_table, "pci", "0000:03:00.0", 2001, "pf0sf88888",
+                   88888, 0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_SF,
+                   eth_addr_zero, PORT_NODE_SOURCE_DUMP));
+    ovs_assert(port_table_lookup_pf_mac_sf(port_table, pf_mac, 88888));
+
+    smap_init(&iface_options);
+    port_node_fill_iface_options(sf, &iface_options);
+    ovs_assert(!strcmp(smap_get(&iface_options, OPT_SF_NUM), "1"));
+    ovs_assert(!smap_get(&iface_options, OPT_VF_NUM));
+    ovs_assert(!smap_get(&iface_options, OPT_SF_PROVISIONED));
+
+    /* Ownership of an SF is only taken over from options describing it. */
+    smap_add(&iface_options, OPT_SF_PROVISIONED, "true");
+    port_node_adopt_sf(vf, &iface_options);
+    port_node_adopt_sf(port_table_lookup_pf_mac_sf(port_table, pf_mac, 88888),
+                       &iface_options);
+    ovs_assert(!function_node_cast(vf)->provisioned);
+    ovs_assert(!function_node_cast(port_table_lookup_pf_mac_sf(
+                                       port_table, pf_mac, 88888))
+                    ->provisioned);
+    port_node_adopt_sf(sf, &iface_options);
+    ovs_assert(function_node_cast(sf)->provisioned);
+    smap_destroy(&iface_options);
+
+    /* SFs follow changes to the PF MAC. */
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 100, "p0hpf", UINT32_MAX,
+        0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_PF, pf_mac2,
+        PORT_NODE_SOURCE_DUMP);
+    ovs_assert(!port_table_lookup_pf_mac_sf(port_table, pf_mac, 1));
+    ovs_assert(port_table_lookup_pf_mac_sf(port_table, pf_mac2, 1) == sf);
+
+    /* Deleting an SF leaves the VF with the same number alone. */
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0", 1, 0,
+                            UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_SF);
+    ovs_assert(!port_table_lookup_pf_mac_sf(port_table, pf_mac2, 1));
+    ovs_assert(port_table_lookup_pf_mac_vf(port_table, pf_mac2, 1) == vf);
+
+    /* SFs reported before their PF are parked like VFs. */
+    ovs_assert(!port_table_update_entry(
+                   port_table, "pci", "0000:03:00.1", 3000, "pf1sf1", 1,
+                   1, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_SF,
+                   eth_addr_zero, PORT_NODE_SOURCE_DUMP));
+    ovs_assert(!port_table_update_entry(
+                   port_table, "pci", "0000:03:00.1", 3001, "pf1vf1",
+                   UINT32_MAX, 1, 1, DEVLINK_PORT_FLAVOUR_PCI_VF,
+                   eth_addr_zero, PORT_NODE_SOURCE_DUMP));
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.1", 101, "p1hpf", UINT32_MAX,
+        1, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_PF,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,44),
+        PORT_NODE_SOURCE_DUMP);
+    sf = port_table_lookup_pf_mac_sf(
+            port_table, (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,44), 1);
+    ovs_assert(sf && sf->netdev_ifindex == 3000);
+    vf = port_table_lookup_pf_mac_vf(
+            port_table, (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,44), 1);
+    ovs_assert(vf && vf->netdev_ifindex == 3001);
+
+    _destroy_store();
+}
+
+static void
+test_port_table_provision_sf(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct eth_addr pf_mac = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42);
+    struct eth_addr mac = (struct eth_addr) ETH_ADDR_C(00,53,00,00,20,05);
+    struct dl_port dl_port = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .index = 7,
+        .netdev_ifindex = 2005,
+        .netdev_name = "eth0",
+        .flavour = DEVLINK_PORT_FLAVOUR_PCI_SF,
+        .pci_pf_number = 0,
+        .pci_vf_number = UINT16_MAX,
+        .pci_sf_number = 5,
+    };
+    struct dl_port pf_port = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .index = 1,
+        .netdev_ifindex = 100,
+        .netdev_name = "p0hpf",
+        .number = UINT32_MAX,
+        .pci_pf_number = 0,
+        .pci_vf_number = UINT16_MAX,
+        .flavour = DEVLINK_PORT_FLAVOUR_PCI_PF,
+        .function.eth_addr = ETH_ADDR_C(00,53,00,00,00,42),
+        .external = 1,
+        .controller_number = 1,
+    };
+    struct smap iface_options;
+    struct phy_node *pf;
+    struct port_node *pn;
+
+    _init_store();
+
+    pf = port_table_lookup_pf_mac(port_table, pf_mac);
+    ovs_assert(pf && pf->up.flavour == DEVLINK_PORT_FLAVOUR_PCI_PF);
+    ovs_assert(!port_table_lookup_pf_mac(port_table, mac));
+
+    /* Requests are queued once, and failure to create the SF drops the
+     * request. */
+    devlink_port_new_error = ENOSPC;
+    ovs_assert(phy_node_request_sf(pf, 5, mac));
+    ovs_assert(!phy_node_request_sf(pf, 5, mac));
+    ovs_assert(ovs_list_size(&pf->sf_requests) == 1);
+    ovs_assert(!port_table_sf_requests_run(port_table, LLONG_MAX));
+    ovs_assert(devlink_port_function_set_calls == 0);
+    ovs_assert(ovs_list_is_empty(&pf->sf_requests));
+    devlink_port_new_error = 0;
+
+    /* Failure to activate the SF deletes it again. */
+    devlink_port_new_result = &dl_port;
+    devlink_port_function_set_error = EIO;
+    ovs_assert(phy_node_request_sf(pf, 5, mac));
+    ovs_assert(!port_table_sf_requests_run(port_table, LLONG_MAX));
+    ovs_assert(devlink_port_del_calls == 1);
+    ovs_assert(devlink_port_del_last_index == 7);
+    ovs_assert(!port_table_lookup_pf_mac_sf(port_table, pf_mac, 5));
+    ovs_assert(ovs_list_is_empty(&pf->sf_requests));
+    devlink_port_function_set_error = 0;
+
+    /* The SF is programmed, activated and inserted right away. */
+    ovs_assert(phy_node_request_sf(pf, 5, mac));
+    ovs_assert(port_table_sf_requests_run(port_table, LLONG_MAX));
+    ovs_assert(ovs_list_is_empty(&pf->sf_requests));
+    pn = port_table_lookup_pf_mac_sf(port_table, pf_mac, 5);
+    ovs_assert(devlink_port_new_last_sf_number == 5);
+    ovs_assert(devlink_port_new_last_controller == UINT32_MAX);
+    ovs_assert(eth_addr_equals(devlink_port_function_set_last.eth_addr,
+                               mac));
+    ovs_assert(devlink_port_function_set_last.state
+               == DEVLINK_PORT_FN_STATE_ACTIVE);
+    ovs_assert(pn && pn->dl_port_index == 7);
+    ovs_assert(port_table_lookup_function_mac(port_table, mac) == pn);
+    ovs_assert(function_node_cast(pn)->provisioned);
+#ifdef RENAME_TRACKING
+    /* The representor was just created and will likely be renamed. */
+    ovs_assert(port_node_rename_expected(pn));
+#endif /* RENAME_TRACKING */
+
+    /* Unplugging only deletes SFs the Interface options say we created. */
+    smap_init(&iface_options);
+    port_node_fill_iface_options(pn, &iface_options);
+    ovs_assert(smap_get_bool(&iface_options, OPT_SF_PROVISIONED,
+                             false));
+    smap_remove(&iface_options, OPT_SF_PROVISIONED);
+    vif_plug_representor_remove_sf("lsp1", &iface_options);
+    ovs_assert(devlink_port_del_calls == 1);
+    smap_add(&iface_options, OPT_SF_PROVISIONED, "true");
+    vif_plug_representor_remove_sf("lsp1", &iface_options);
+    ovs_assert(devlink_port_del_calls == 2);
+    ovs_assert(devlink_port_del_last_index == 7);
+    smap_destroy(&iface_options);
+
+    ovs_assert(!port_node_delete_sf(pn));
+    ovs_assert(devlink_port_del_calls == 3);
+    ovs_assert(devlink_port_del_last_index == 7);
+    ovs_assert(port_node_delete_sf(&pf->up) == EINVAL);
+
+    /* Without a netdev in the reply the representor is left to the devlink
+     * notification.  SFs of the PF of a SmartNIC host are created on its
+     * controller. */
+    port_table_update_devlink_port(&pf_port, PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(pf->controller == 1 && pf->external);
+    dl_port.index = 8;
+    dl_port.netdev_ifindex = UINT32_MAX;
+    dl_port.netdev_name = NULL;
+    dl_port.pci_sf_number = 6;
+    ovs_assert(phy_node_request_sf(pf, 6, eth_addr_zero));
+    ovs_assert(!port_table_sf_requests_run(port_table, LLONG_MAX));
+    ovs_assert(!port_table_lookup_pf_mac_sf(port_table, pf_mac, 6));
+    ovs_assert(devlink_port_new_last_controller == 1);
+    ovs_assert(phy_node_find_sf_request(pf, 6));
+
+    devlink_port_new_result = NULL;
+    devlink_port_function_set_calls = 0;
+    devlink_port_del_calls = 0;
+    _destroy_store();
+}
+
+static void
+test_port_table_resync(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct dl_port pf_port = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .index = 1,
+        .netdev_ifindex = 100,
+        .netdev_name = "p0hpf",
+        .number = UINT32_MAX,
+        .pci_pf_number = 0,
+        .pci_vf_number = UINT16_MAX,
+        .flavour = DEVLINK_PORT_FLAVOUR_PCI_PF,
+        .function.eth_addr = ETH_ADDR_C(00,53,00,00,00,42),
+        .external = 1,
+    };
+    struct dl_port vf_port = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .index = 2,
+        .netdev_ifindex = UINT32_MAX,
+        .number = UINT32_MAX,
+        .pci_pf_number = 0,
+        .pci_vf_number = 0,
+        .flavour = DEVLINK_PORT_FLAVOUR_PCI_VF,
+    };
+
+    _init_store();
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 1000, "pf0vf0", UINT32_MAX,
+        0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
         PORT_NODE_SOURCE_DUMP);
     port_table_update_entry(
-        port_table, "pci", "0000:03:00.0", 100, "p0hpf", UINT32_MAX,
-        0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_PF,
-        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42),
+        port_table, "pci", "0000:03:00.0", 1001, "pf0vf1", UINT32_MAX,
+        0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,01),
         PORT_NODE_SOURCE_DUMP);
-}
 
-static void
-_destroy_store(void)
-{
-    port_table_destroy(port_table);
+    /* Ports not reported by the dump are removed, while ports reported
+     * without a netdev are kept as they are. */
+    port_table_resync_mark(port_table);
+    port_resync_reply(&pf_port, NULL);
+    port_resync_reply(&vf_port, NULL);
+    port_table_sweep_resync(port_table);
+
+    ovs_assert(port_table_lookup_ifindex(port_table, 100));
+    ovs_assert(port_table_lookup_ifindex(port_table, 1000));
+    ovs_assert(!strcmp(port_table_lookup_ifindex(port_table, 1000)
+                       ->netdev_name, "pf0vf0"));
+    ovs_assert(!port_table_lookup_ifindex(port_table, 1001));
+    ovs_assert(!port_table_lookup_ifindex(port_table, 10));
+
+    _destroy_store();
 }
 
 static void
-test_phy_store(struct ovs_cmdl_context *ctx OVS_UNUSED)
+test_port_table_dump_ready(struct ovs_cmdl_context *ctx OVS_UNUSED)
 {
-    struct port_node *pn;
+    struct dl_port pf_port = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .index = 1,
+        .netdev_ifindex = 100,
+        .netdev_name = "p0hpf",
+        .number = UINT32_MAX,
+        .pci_pf_number = 0,
+        .pci_vf_number = UINT16_MAX,
+        .flavour = DEVLINK_PORT_FLAVOUR_PCI_PF,
+        .function.eth_addr = ETH_ADDR_C(00,53,00,00,00,42),
+        .external = 1,
+    };
 
     _init_store();
+    port_table_ready = false;
+
+    /* A failed initial dump does not make the table ready, a
+     * resynchronization dump is scheduled in its place. */
+    devlink_port_dump_done(EIO, NULL);
+    ovs_assert(!devlink_port_dump_finish());
+    ovs_assert(!port_table_ready);
+    ovs_assert(port_dump_failed);
+    ovs_assert(port_dump_retry <= time_msec());
+
+    /* Neither does a failed resynchronization dump, which is retried later
+     * and leaves the table as it is. */
+    port_table_resync_mark(port_table);
+    port_resync_done(EIO, NULL);
+    port_table_resync_finish(port_table);
+    ovs_assert(!port_table_ready);
+    ovs_assert(port_dump_failed);
+    ovs_assert(port_dump_retry > time_msec());
+    ovs_assert(port_table_lookup_ifindex(port_table, 10));
+
+    /* The table is ready once one completes. */
+    port_table_resync_mark(port_table);
+    port_resync_reply(&pf_port, NULL);
+    port_resync_done(0, NULL);
+    port_table_resync_finish(port_table);
+    ovs_assert(port_table_ready);
+    ovs_assert(!port_dump_failed);
+    ovs_assert(port_table_lookup_ifindex(port_table, 100));
+    ovs_assert(!port_table_lookup_ifindex(port_table, 10));
+
+    /* A successful initial dump makes it ready right away. */
+    port_table_ready = false;
+    devlink_port_dump_done(0, NULL);
+    ovs_assert(devlink_port_dump_finish());
+    ovs_assert(port_table_ready);
+    ovs_assert(!port_dump_failed);
 
-    pn = port_table_lookup_phy_bus_dev(port_table, "pci", "0000:03:00.0",
-                                       DEVLINK_PORT_FLAVOUR_PHYSICAL, 0);
-    ovs_assert(pn);
-    ovs_assert(pn->netdev_ifindex == 10);
-    ovs_assert(!strcmp(pn->netdev_name, "p0"));
-    ovs_assert(
-        eth_addr_equals(pn->mac,
-                        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,00)));
-    ovs_assert(pn->flavour == DEVLINK_PORT_FLAVOUR_PHYSICAL);
-    ovs_assert(pn->number == 0);
-
-    ovs_assert(pn == port_table_lookup_ifindex(port_table, 10));
+    _destroy_store();
+}
 
-    pn = port_table_lookup_phy_bus_dev(port_table, "pci", "0000:03:00.0",
-                                       DEVLINK_PORT_FLAVOUR_PCI_PF, 0);
-    ovs_assert(pn);
-    ovs_assert(pn->netdev_ifindex == 100);
-    ovs_assert(!strcmp(pn->netdev_name, "p0hpf"));
-    ovs_assert(
-        eth_addr_equals(pn->mac,
-                        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42)));
-    ovs_assert(pn == port_table_lookup_ifindex(port_table, 100));
+static void
+test_port_table_sf_pool(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct eth_addr pf_mac = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42);
+    struct eth_addr mac0 = (struct eth_addr) ETH_ADDR_C(00,53,00,00,30,00);
+    struct eth_addr mac1 = (struct eth_addr) ETH_ADDR_C(00,53,00,00,30,01);
+    struct dl_port dl_port = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .index = 9,
+        .netdev_ifindex = UINT32_MAX,
+        .flavour = DEVLINK_PORT_FLAVOUR_PCI_SF,
+        .pci_pf_number = 0,
+        .pci_vf_number = UINT16_MAX,
+    };
+    struct port_node *pn, *sf0, *sf1;
+    struct phy_node *pf;
 
+    _init_store();
+    pf = port_table_lookup_pf_mac(port_table, pf_mac);
+    devlink_port_new_result = &dl_port;
+    sf_provisioning = true;
+    sf_pool_size = 2;
+
+    /* Idle SFs are requested, and then created and activated separately. */
+    sf_pool_next_run = 0;
+    port_table_sf_pool_run(port_table, time_msec());
+    ovs_assert(ovs_list_size(&pf->sf_requests) == 2);
+    ovs_assert(devlink_port_function_set_calls == 0);
+    ovs_assert(!port_table_sf_requests_run(port_table, LLONG_MAX));
+    ovs_assert(devlink_port_new_last_sf_number == SF_POOL_NUM_BASE + 1);
+    ovs_assert(devlink_port_function_set_calls == 2);
+    ovs_assert(eth_addr_is_zero(devlink_port_function_set_last.eth_addr));
+    ovs_assert(devlink_port_function_set_last.state
+               == DEVLINK_PORT_FN_STATE_ACTIVE);
+
+    /* SFs whose representor is yet to be reported are not requested
+     * again. */
+    sf_pool_next_run = 0;
+    port_table_sf_pool_run(port_table, time_msec());
+    ovs_assert(ovs_list_size(&pf->sf_requests) == 2);
+    ovs_assert(!port_table_sf_requests_run(port_table, LLONG_MAX));
+    ovs_assert(devlink_port_function_set_calls == 2);
+
+    /* The representors are reported by devlink notifications. */
+    sf0 = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 3000, "pf0sf65536",
+            SF_POOL_NUM_BASE, 0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_SF,
+            eth_addr_zero, PORT_NODE_SOURCE_DUMP);
+    sf1 = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 3001, "pf0sf65537",
+            SF_POOL_NUM_BASE + 1, 0, UINT16_MAX,
+            DEVLINK_PORT_FLAVOUR_PCI_SF, eth_addr_zero,
+            PORT_NODE_SOURCE_DUMP);
+    ovs_assert(sf0 && sf1);
+    ovs_assert(ovs_list_is_empty(&pf->sf_requests));
+    sf0->dl_port_index = 10;
+    sf1->dl_port_index = 11;
+
+    /* A full pool is left alone. */
+    sf_pool_next_run = 0;
+    port_table_sf_pool_run(port_table, time_msec());
+    ovs_assert(devlink_port_function_set_calls == 2);
+    ovs_assert(sf_pool_next_run > time_msec());
+
+    /* Claiming programs the MAC of an idle SF, and is idempotent. */
+    ovs_assert(!_sf_pool_claim(pf, mac0, &pn));
+    ovs_assert(pn == sf0);
+    ovs_assert(devlink_port_function_set_calls == 3);
+    ovs_assert(eth_addr_equals(devlink_port_function_set_last.eth_addr,
+                               mac0));
+    ovs_assert(port_table_lookup_function_mac(port_table, mac0) == sf0);
+    ovs_assert(sf_pool_next_run == 0);
+    ovs_assert(!_sf_pool_claim(pf, mac0, &pn));
+    ovs_assert(pn == sf0);
+    ovs_assert(devlink_port_function_set_calls == 3);
+
+    /* The pool is refilled past the claimed SF. */
+    port_table_sf_pool_run(port_table, time_msec());
+    ovs_assert(!port_table_sf_requests_run(port_table, LLONG_MAX));
+    ovs_assert(devlink_port_new_last_sf_number == SF_POOL_NUM_BASE + 2);
+    ovs_assert(devlink_port_function_set_calls == 4);
+
+    /* Surplus idle SFs are deleted when the pool shrinks. */
+    sf_pool_size = 0;
+    sf_pool_next_run = 0;
+    port_table_sf_pool_run(port_table, time_msec());
+    ovs_assert(devlink_port_del_calls == 1);
+    ovs_assert(devlink_port_del_last_index == 11);
+    ovs_assert(devlink_port_function_set_calls == 4);
     port_table_delete_entry(port_table, "pci", "0000:03:00.0",
-                            UINT32_MAX, 0, UINT16_MAX,
-                            DEVLINK_PORT_FLAVOUR_PCI_PF);
+                            SF_POOL_NUM_BASE + 1, 0, UINT16_MAX,
+                            DEVLINK_PORT_FLAVOUR_PCI_SF);
 
-    pn = port_table_lookup_phy_bus_dev(port_table, "pci", "0000:03:00.0",
-                                       DEVLINK_PORT_FLAVOUR_PCI_PF, 0);
+    /* An empty pool falls back to requesting an SF on demand, once. */
+    ovs_assert(!_sf_pool_claim(pf, mac1, &pn));
     ovs_assert(!pn);
-
-    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
-                            0, UINT16_MAX, UINT16_MAX,
-                            DEVLINK_PORT_FLAVOUR_PHYSICAL);
-
-    pn = port_table_lookup_phy_bus_dev(port_table, "pci", "0000:03:00.0",
-                                       DEVLINK_PORT_FLAVOUR_PHYSICAL, 0);
+    ovs_assert(ovs_list_size(&pf->sf_requests) == 2);
+    ovs_assert(!_sf_pool_claim(pf, mac1, &pn));
     ovs_assert(!pn);
-
-    /* confirm that we would not misbehave on attempt to delete non-existing
-     * entries. */
-    port_table_delete_entry(port_table, "nonexistent", "device",
-                            UINT32_MAX, 0, UINT16_MAX,
-                            DEVLINK_PORT_FLAVOUR_PCI_PF);
-    port_table_delete_entry(port_table, "nonexistent", "device",
-                            0, UINT16_MAX, UINT16_MAX,
-                            DEVLINK_PORT_FLAVOUR_PHYSICAL);
-
+    ovs_assert(ovs_list_size(&pf->sf_requests) == 2);
+    ovs_assert(!port_table_sf_requests_run(port_table, LLONG_MAX));
+    ovs_assert(devlink_port_new_last_sf_number == SF_POOL_NUM_BASE + 3);
+    ovs_assert(eth_addr_equals(devlink_port_function_set_last.eth_addr,
+                               mac1));
+    sf_provisioning = false;
+    ovs_assert(_sf_pool_claim(pf, mac1, &pn)
+               == ENOENT);
+
+    /* Requests whose representor does not appear are given up on. */
+    ovs_assert(phy_node_find_sf_request(pf, SF_POOL_NUM_BASE + 2));
+    ovs_assert(!port_table_sf_request_next(
+                    port_table, time_msec() + SF_REQUEST_TIMEOUT_MSEC, NULL));
+    ovs_assert(ovs_list_is_empty(&pf->sf_requests));
+
+    /* Failed creations are given up on right away. */
+    sf_provisioning = true;
+    sf_pool_size = 1;
+    sf_pool_next_run = 0;
+    devlink_port_new_error = ENOSPC;
+    port_table_sf_pool_run(port_table, time_msec());
+    ovs_assert(ovs_list_size(&pf->sf_requests) == 1);
+    ovs_assert(!port_table_sf_requests_run(port_table, LLONG_MAX));
+    ovs_assert(ovs_list_is_empty(&pf->sf_requests));
+    devlink_port_new_error = 0;
+    sf_provisioning = false;
+
+    sf_pool_size = 0;
+    sf_pool_next_run = 0;
+    devlink_port_new_result = NULL;
+    devlink_port_function_set_calls = 0;
+    devlink_port_del_calls = 0;
     _destroy_store();
 }
 
 static void
-test_port_store(struct ovs_cmdl_context *ctx OVS_UNUSED)
+test_port_node_set_rate(struct ovs_cmdl_context *ctx OVS_UNUSED)
 {
-    struct port_node *pn;
+    struct dl_rate stale = {
+        .type = DEVLINK_RATE_TYPE_LEAF,
+        .port_index = 1,
+        .tx_share = 0,
+        .tx_max = 1000,
+        .parent_node_name = "",
+    };
+    struct port_node *pf, *pn;
 
     _init_store();
 
-    port_table_update_entry(
-        port_table, "pci", "0000:03:00.0", 1000, "pf0vf0", UINT32_MAX,
-        0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
-        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
-        PORT_NODE_SOURCE_RUNTIME);
-
-    pn = port_table_lookup_ifindex(port_table, 1000);
-
-    ovs_assert(pn);
-    ovs_assert(pn->netdev_ifindex == 1000);
-    ovs_assert(!strcmp(pn->netdev_name, "pf0vf0"));
-    ovs_assert(
-        eth_addr_equals(pn->mac,
-                        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00)));
-    ovs_assert(pn->flavour == DEVLINK_PORT_FLAVOUR_PCI_VF);
-    ovs_assert(pn->number == 0);
-    ovs_assert(pn->port_node_source == PORT_NODE_SOURCE_RUNTIME);
-
-    ovs_assert(pn->pf);
-    ovs_assert(!strcmp(pn->pf->netdev_name, "p0hpf"));
-
-    pn = port_table_lookup_pf_mac_vf(
-        port_table,
-        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42),
-        0);
-
+    pn = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "pf0vf0",
+            UINT32_MAX, 0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+            PORT_NODE_SOURCE_DUMP);
     ovs_assert(pn);
-    ovs_assert(pn->netdev_ifindex == 1000);
-    ovs_assert(!strcmp(pn->netdev_name, "pf0vf0"));
-    ovs_assert(
-        eth_addr_equals(pn->mac,
-                        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00)));
-
-    port_table_delete_entry(port_table, "pci", "0000:03:00.0", UINT32_MAX,
-                            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF);
-
-    pn = port_table_lookup_ifindex(port_table, 1000);
-    ovs_assert(!pn);
-
-    pn = port_table_lookup_pf_mac_vf(
-        port_table,
-        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42),
-        0);
+    ovs_mutex_lock(&port_table_mutex);
+
+    /* Without a devlink port index only the default can be satisfied. */
+    ovs_assert(!port_table_set_rate(port_table, &pn, 0, 0, ""));
+    ovs_assert(port_table_set_rate(port_table, &pn, 0, 1000, "") == EAGAIN);
+    ovs_assert(devlink_rate_get_calls == 0);
+    ovs_assert(devlink_rate_set_calls == 0);
+    pn->dl_port_index = 1;
+
+    /* Rates left behind on the leaf are learned once and reset. */
+    devlink_rate_get_result = &stale;
+    ovs_assert(!port_table_set_rate(port_table, &pn, 0, 0, ""));
+    ovs_assert(devlink_rate_get_calls == 1);
+    ovs_assert(devlink_rate_set_calls == 1);
+    ovs_assert(devlink_rate_set_last.port_index == 1);
+    ovs_assert(devlink_rate_set_last.tx_share == UINT64_MAX);
+    ovs_assert(devlink_rate_set_last.tx_max == 0);
+    ovs_assert(!devlink_rate_set_last.parent_node_name);
+
+    /* Joining a group creates it, an existing group is fine. */
+    devlink_rate_new_error = EEXIST;
+    ovs_assert(!port_table_set_rate(port_table, &pn, 100, 200, "tenant0"));
+    ovs_assert(devlink_rate_new_calls == 1);
+    ovs_assert(devlink_rate_set_calls == 2);
+    ovs_assert(devlink_rate_set_last.tx_share == 100);
+    ovs_assert(devlink_rate_set_last.tx_max == 200);
+    ovs_assert(!strcmp(devlink_rate_set_last.parent_node_name, "tenant0"));
+    devlink_rate_new_error = 0;
+
+    /* Nothing is sent when nothing changed. */
+    ovs_assert(!port_table_set_rate(port_table, &pn, 100, 200, "tenant0"));
+    ovs_assert(devlink_rate_get_calls == 1);
+    ovs_assert(devlink_rate_new_calls == 1);
+    ovs_assert(devlink_rate_set_calls == 2);
+
+    /* A failed request is retried on the next attempt. */
+    devlink_rate_set_error = EOPNOTSUPP;
+    ovs_assert(port_table_set_rate(port_table, &pn, 100, 300, "tenant0")
+               == EOPNOTSUPP);
+    devlink_rate_set_error = 0;
+    ovs_assert(!port_table_set_rate(port_table, &pn, 100, 300, "tenant0"));
+    ovs_assert(devlink_rate_new_calls == 1);
+    ovs_assert(devlink_rate_set_calls == 4);
+    ovs_assert(devlink_rate_set_last.tx_share == UINT64_MAX);
+    ovs_assert(devlink_rate_set_last.tx_max == 300);
+    ovs_assert(!devlink_rate_set_last.parent_node_name);
+
+    /* Leaving the group detaches the leaf from its parent. */
+    ovs_assert(!port_table_set_rate(port_table, &pn, 100, 300, ""));
+    ovs_assert(devlink_rate_new_calls == 1);
+    ovs_assert(devlink_rate_set_calls == 5);
+    ovs_assert(!strcmp(devlink_rate_set_last.parent_node_name, ""));
+
+    /* A failure to create the group is reported. */
+    devlink_rate_new_error = ENOSPC;
+    ovs_assert(port_table_set_rate(port_table, &pn, 100, 300, "tenant1")
+               == ENOSPC);
+    ovs_assert(devlink_rate_set_calls == 5);
+    devlink_rate_new_error = 0;
+
+    /* The mutex is released during the transactions, a port removed in the
+     * meantime is not touched. */
+    devlink_rate_set_hook = _delete_vf0;
+    ovs_assert(port_table_set_rate(port_table, &pn, 100, 400, "")
+               == ENODEV);
     ovs_assert(!pn);
+    ovs_assert(devlink_rate_set_calls == 6);
+    devlink_rate_set_hook = NULL;
+
+    /* PF representors have no rate leaf. */
+    pf = _lookup_phy(port_table, "pci", "0000:03:00.0",
+                     DEVLINK_PORT_FLAVOUR_PCI_PF, 0);
+    ovs_assert(port_table_set_rate(port_table, &pf, 0, 1000, "") == EINVAL);
+
+    ovs_mutex_unlock(&port_table_mutex);
+    devlink_rate_get_result = NULL;
+    devlink_rate_get_calls = 0;
+    devlink_rate_set_calls = 0;
+    devlink_rate_new_calls = 0;
+    _destroy_store();
+}
 
-    /* confirm that we would not misbehave on attempt to delete non-existing
-     * entries. */
-    port_table_delete_entry(port_table, "non", "existing", UINT32_MAX,
-                            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF);
+static struct devlink_param_entry *
+_devlink_params_first(void)
+{
+    ovs_assert(!ovs_list_is_empty(&devlink_params));
+    return CONTAINER_OF(ovs_list_front(&devlink_params),
+                        struct devlink_param_entry, list_node);
+}
 
-    _destroy_store();
+static void
+test_devlink_params(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct dl_param steering = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .name = "flow_steering_mode",
+        .type = DL_PARAM_TYPE_STRING,
+        .n_values = 1,
+        .values = {
+            { .cmode = DEVLINK_PARAM_CMODE_RUNTIME, .string = "dmfs", },
+        },
+    };
+    struct dl_param roce = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .name = "enable_roce",
+        .type = DL_PARAM_TYPE_BOOL,
+        .n_values = 2,
+        .values = {
+            { .cmode = DEVLINK_PARAM_CMODE_PERMANENT, .data = 1, },
+            { .cmode = DEVLINK_PARAM_CMODE_DRIVERINIT, .data = 1, },
+        },
+    };
+    long long int now = time_msec();
+    struct devlink_param_entry *entry;
+
+    /* Malformed entries are skipped. */
+    devlink_params_configure("pci/0000:03:00.0/flow_steering_mode=smfs, "
+                             "pci/0000:03:00.0, /0000:03:00.0/x=1 "
+                             "pci/0000:03:00.0/=1");
+    ovs_assert(ovs_list_size(&devlink_params) == 1);
+    entry = _devlink_params_first();
+    ovs_assert(!strcmp(entry->bus_name, "pci"));
+    ovs_assert(!strcmp(entry->dev_name, "0000:03:00.0"));
+    ovs_assert(!strcmp(entry->name, "flow_steering_mode"));
+    ovs_assert(!strcmp(entry->value, "smfs"));
+
+    /* Lports are held back until each entry was checked once, even if that
+     * failed.  An absent device or parameter is retried. */
+    ovs_assert(devlink_params_pending());
+    ovs_assert(devlink_params_run(now));
+    ovs_assert(!devlink_params_pending());
+    ovs_assert(entry->error == EINVAL);
+    ovs_assert(devlink_param_set_calls == 0);
+
+    /* The runtime value is set and verified, and checked again only once
+     * the interval has passed. */
+    devlink_param_stub = &steering;
+    ovs_assert(!devlink_params_run(now));
+    ovs_assert(devlink_param_set_calls == 0);
+    ovs_assert(!devlink_params_run(now + DEVLINK_PARAMS_RUN_INTERVAL_MSEC));
+    ovs_assert(!entry->error);
+    ovs_assert(devlink_param_set_calls == 1);
+    ovs_assert(devlink_param_set_last.cmode == DEVLINK_PARAM_CMODE_RUNTIME);
+    ovs_assert(!strcmp(steering.values[0].string, "smfs"));
+    devlink_params_run(now + 2 * DEVLINK_PARAMS_RUN_INTERVAL_MSEC);
+    ovs_assert(!entry->error);
+    ovs_assert(devlink_param_set_calls == 1);
+
+    /* Reconfiguring the same profile does not reset the schedule. */
+    devlink_params_configure("pci/0000:03:00.0/flow_steering_mode=smfs, "
+                             "pci/0000:03:00.0, /0000:03:00.0/x=1 "
+                             "pci/0000:03:00.0/=1");
+    ovs_assert(devlink_params_next_run
+               == now + 3 * DEVLINK_PARAMS_RUN_INTERVAL_MSEC);
+
+    /* Drift is corrected, a value that does not stick is reported. */
+    steering.values[0].string = "dmfs";
+    devlink_param_set_ignore = true;
+    devlink_params_run(now + 3 * DEVLINK_PARAMS_RUN_INTERVAL_MSEC);
+    ovs_assert(entry->error == EIO);
+    ovs_assert(devlink_param_set_calls == 2);
+    devlink_param_set_ignore = false;
+
+    devlink_param_set_error = EOPNOTSUPP;
+    devlink_params_run(now + 4 * DEVLINK_PARAMS_RUN_INTERVAL_MSEC);
+    ovs_assert(entry->error == EOPNOTSUPP);
+    ovs_assert(devlink_param_set_calls == 3);
+    devlink_param_set_error = 0;
+
+    /* Without a runtime mode the driverinit value is set, the permanent one
+     * is left alone. */
+    devlink_param_stub = &roce;
+    devlink_params_configure("pci/0000:03:00.0/enable_roce=false");
+    entry = _devlink_params_first();
+    ovs_assert(devlink_params_pending());
+    ovs_assert(devlink_params_run(now));
+    ovs_assert(!entry->error);
+    ovs_assert(devlink_param_set_calls == 4);
+    ovs_assert(devlink_param_set_last.cmode
+               == DEVLINK_PARAM_CMODE_DRIVERINIT);
+    ovs_assert(roce.values[0].data == 1);
+    ovs_assert(roce.values[1].data == 0);
+
+    /* Values are parsed according to the type of the parameter. */
+    devlink_params_configure("pci/0000:03:00.0/enable_roce=1");
+    entry = _devlink_params_first();
+    devlink_params_run(now);
+    ovs_assert(entry->error == EINVAL);
+    ovs_assert(devlink_param_set_calls == 4);
+
+    /* Parameters with only a permanent value are not managed. */
+    roce.n_values = 1;
+    devlink_params_configure("pci/0000:03:00.0/enable_roce=true");
+    entry = _devlink_params_first();
+    devlink_params_run(now);
+    ovs_assert(entry->error == EOPNOTSUPP);
+    ovs_assert(devlink_param_set_calls == 4);
+
+    devlink_params_configure("");
+    ovs_assert(ovs_list_is_empty(&devlink_params));
+    free(devlink_params_cfg);
+    devlink_params_cfg = NULL;
+    devlink_param_stub = NULL;
+    devlink_param_set_calls = 0;
 }
 
 static void
-test_port_node_rename_expected(struct ovs_cmdl_context *ctx OVS_UNUSED)
+test_port_table_bdf(struct ovs_cmdl_context *ctx OVS_UNUSED)
 {
-    struct port_node *pn;
+    struct port_node *pf, *pn;
+    uint32_t bdf;
+
+    ovs_assert(pci_bdf_from_string("0000:03:00.2", &bdf) && bdf == 0x0302);
+    ovs_assert(pci_bdf_from_string("0001:82:1f.7", &bdf)
+               && bdf == 0x000182ff);
+    ovs_assert(pci_bdf_from_string("03:00.3", &bdf) && bdf == 0x0303);
+    ovs_assert(!pci_bdf_from_string("03:00.8", &bdf));
+    ovs_assert(!pci_bdf_from_string("03:20.0", &bdf));
+    ovs_assert(!pci_bdf_from_string("0000:03:00.0x", &bdf));
+    ovs_assert(!pci_bdf_from_string("p0hpf", &bdf));
 
     _init_store();
 
-    pn = port_table_lookup_ifindex(port_table, 100);
-    ovs_assert(port_node_rename_expected(pn) == false);
-
-    pn = port_table_update_entry(
-            port_table, "pci", "0000:03:00.0", 1000, "eth0", UINT32_MAX,
-            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+    /* VFs reported before the PF is probed are indexed by the probe. */
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "pf0vf0",
+            UINT32_MAX, 0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
             (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+            PORT_NODE_SOURCE_DUMP);
+    ovs_assert(!port_table_lookup_bdf(port_table, 0x0302));
+
+    /* External PFs belong to another host, their layout is unknown. */
+    pf = _lookup_phy(port_table, "pci", "0000:03:00.0",
+                     DEVLINK_PORT_FLAVOUR_PCI_PF, 0);
+    port_table_probe_pf_sriov(port_table, phy_node_cast(pf), true);
+    ovs_assert(!port_table_lookup_bdf(port_table, 0x0302));
+    phy_node_cast(pf)->sriov_probed = false;
+
+    /* A failed probe is retried. */
+    sysfs_sriov_stride = NULL;
+    port_table_probe_pf_sriov(port_table, phy_node_cast(pf), false);
+    ovs_assert(!phy_node_cast(pf)->sriov_probed);
+    ovs_assert(!port_table_lookup_bdf(port_table, 0x0302));
+
+    /* Malformed values are rejected, trailing whitespace is not. */
+    sysfs_sriov_stride = "2x\n";
+    port_table_probe_pf_sriov(port_table, phy_node_cast(pf), false);
+    ovs_assert(!phy_node_cast(pf)->sriov_probed);
+
+    sysfs_sriov_offset = "2\n";
+    sysfs_sriov_stride = "2 \n";
+    port_table_probe_pf_sriov(port_table, phy_node_cast(pf), false);
+    ovs_assert(phy_node_cast(pf)->sriov_probed);
+    pn = port_table_lookup_bdf(port_table, 0x0302);
+    ovs_assert(pn && pn->netdev_ifindex == 1000);
+
+    /* VFs reported after the PF is probed are indexed on insert. */
+    port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1001, "pf0vf1",
+            UINT32_MAX, 0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,01),
             PORT_NODE_SOURCE_RUNTIME);
-    ovs_assert(port_node_rename_expected(pn) == true);
+    ovs_assert(!port_table_lookup_bdf(port_table, 0x0303));
+    pn = port_table_lookup_bdf(port_table, 0x0304);
+    ovs_assert(pn && pn->netdev_ifindex == 1001);
+
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
+                            UINT32_MAX, 0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF);
+    ovs_assert(!port_table_lookup_bdf(port_table, 0x0304));
 
     _destroy_store();
 }
 
+static void
+test_run_budget(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    long long int now = time_msec();
+
+    /* At least one unit of work is always allowed. */
+    ovs_assert(!run_budget_exhausted(now - 1, 0));
+    ovs_assert(run_budget_exhausted(now - 1, 1));
+    ovs_assert(!run_budget_exhausted(now + 60 * 1000, 1));
+    ovs_assert(!run_budget_exhausted(LLONG_MAX, SIZE_MAX));
+
+    run_budget_msec = 0;
+    ovs_assert(run_budget_deadline() == LLONG_MAX);
+    run_budget_msec = RUN_BUDGET_MSEC_DEFAULT;
+    ovs_assert(run_budget_deadline() >= now + RUN_BUDGET_MSEC_DEFAULT);
+
+    /* Calls on behalf of port_prepare do not get a budget of their own, they
+     * do nothing once that of the main loop iteration is used up. */
+    run_deadline = now - 1;
+    ovs_assert(!vif_plug_representor_run(NULL));
+}
+
 static void
 test_port_table_update_devlink_port(struct ovs_cmdl_context *ctx OVS_UNUSED)
 {
@@ -1042,9 +6927,8 @@ test_port_table_update_devlink_port(struct ovs_cmdl_context *ctx OVS_UNUSED)
 
     pn = port_table_lookup_ifindex(port_table, 1000);
     ovs_assert(pn);
-    ovs_assert(pn->pf);
     ovs_assert(
-        eth_addr_equals(pn->pf->mac,
+        eth_addr_equals(function_node_cast(pn)->pf->up.mac,
                         (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42)));
     ovs_assert(pn->port_node_source == PORT_NODE_SOURCE_RUNTIME);
 
@@ -1114,8 +6998,8 @@ test_port_table_update_devlink_port_compat(
      * interface is used to retrieve the MAC. */
     port_table_update_devlink_port(&dl_pf_port, PORT_NODE_SOURCE_DUMP);
 
-    pn = port_table_lookup_phy_bus_dev(port_table, "pci", "0000:03:00.0",
-                                       DEVLINK_PORT_FLAVOUR_PCI_PF, 0);
+    pn = _lookup_phy(port_table, "pci", "0000:03:00.0",
+                     DEVLINK_PORT_FLAVOUR_PCI_PF, 0);
     ovs_assert(pn);
     ovs_assert(
         eth_addr_equals(pn->mac,
@@ -1125,6 +7009,268 @@ test_port_table_update_devlink_port_compat(
     _destroy_store();
 }
 
+static void
+test_port_table_update_devlink_port_compat_cache(
+    struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct dl_port dl_pf_port = {
+        .bus_name = "pci",
+        .dev_name = "0000:03:00.0",
+        .netdev_ifindex = 100,
+        .netdev_name = "pf0hpf",
+        .number = UINT32_MAX,
+        .pci_pf_number = 0,
+        .pci_vf_number = UINT16_MAX,
+        .flavour = DEVLINK_PORT_FLAVOUR_PCI_PF,
+    };
+    struct phy_node *phy;
+
+    _init_store();
+    compat_get_host_pf_mac_calls = 0;
+
+    /* repeated updates to the PF only consult sysfs once. */
+    port_table_update_devlink_port(&dl_pf_port, PORT_NODE_SOURCE_DUMP);
+    port_table_update_devlink_port(&dl_pf_port, PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(compat_get_host_pf_mac_calls == 1);
+
+    phy = port_table_lookup_phy_bus_dev(port_table, "pci", "0000:03:00.0",
+                                        DEVLINK_PORT_FLAVOUR_PHYSICAL, 0);
+    ovs_assert(phy);
+    ovs_assert(phy->compat_pf_mac_valid);
+
+    /* updates without a name change keep the cache. */
+    port_node_update(&phy->up, "p0");
+    ovs_assert(phy->compat_pf_mac_valid);
+
+    /* a rename of the PHYSICAL port invalidates the cache. */
+    port_node_update(&phy->up, "eth0");
+    ovs_assert(!phy->compat_pf_mac_valid);
+    port_node_update(&phy->up, "p0");
+    port_table_update_devlink_port(&dl_pf_port, PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(compat_get_host_pf_mac_calls == 2);
+
+    /* as does removal and re-adding of the PHYSICAL port. */
+    port_table_delete_entry(port_table, "pci", "0000:03:00.0",
+                            0, UINT16_MAX, UINT16_MAX,
+                            DEVLINK_PORT_FLAVOUR_PHYSICAL);
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 10, "p0", 0,
+        UINT16_MAX, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PHYSICAL,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,00),
+        PORT_NODE_SOURCE_RUNTIME);
+    port_table_update_devlink_port(&dl_pf_port, PORT_NODE_SOURCE_RUNTIME);
+    ovs_assert(compat_get_host_pf_mac_calls == 3);
+
+    /* the kernel may change the file behind our back, so it is read again
+     * periodically, and a new MAC re-indexes the PF. */
+    ovs_assert(!port_table_compat_run(port_table, time_msec()));
+    ovs_assert(compat_get_host_pf_mac_calls == 3);
+    compat_host_pf_mac = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,52);
+    ovs_assert(port_table_compat_run(port_table,
+                                     time_msec() + COMPAT_PF_MAC_POLL_MSEC));
+    ovs_assert(compat_get_host_pf_mac_calls == 4);
+    ovs_assert(port_table_lookup_pf_mac(port_table, compat_host_pf_mac));
+    compat_host_pf_mac = (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,51);
+
+    _destroy_store();
+}
+
+static void
+test_port_snapshot(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    const char *file_name = "representor.snapshot";
+    struct port_node *pn;
+
+    _init_store();
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 1000, "pf0vf0", UINT32_MAX,
+        0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+        PORT_NODE_SOURCE_DUMP);
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 1001, "pf0vf1", UINT32_MAX,
+        0, 1, DEVLINK_PORT_FLAVOUR_PCI_VF,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,01),
+        PORT_NODE_SOURCE_DUMP);
+    /* Ports of devices with names too long for a record are left out. */
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0-a-device-name-too-long-for-a-record",
+        20, "p9", 0, UINT16_MAX, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PHYSICAL,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,09),
+        PORT_NODE_SOURCE_DUMP);
+    ovs_assert(port_table_lookup_ifindex(port_table, 20));
+    ovs_assert(!port_snapshot_write(port_table, file_name));
+    _destroy_store();
+
+    /* a snapshot that does not match the kernel is not loaded. */
+    port_table = port_table_create();
+    snapshot_check_ifindex_result = false;
+    ovs_assert(!port_snapshot_load(port_table, file_name));
+    ovs_assert(!port_table_lookup_ifindex(port_table, 10));
+    snapshot_check_ifindex_result = true;
+    snapshot_missing_dev_name = "0000:03:00.0";
+    ovs_assert(!port_snapshot_load(port_table, file_name));
+    ovs_assert(!port_table_lookup_ifindex(port_table, 10));
+    snapshot_missing_dev_name = NULL;
+
+    /* all ports and indexes are restored from a valid snapshot. */
+    ovs_assert(port_snapshot_load(port_table, file_name));
+    pn = _lookup_phy(port_table, "pci", "0000:03:00.0",
+                     DEVLINK_PORT_FLAVOUR_PHYSICAL, 0);
+    ovs_assert(pn);
+    ovs_assert(pn->netdev_ifindex == 10);
+    ovs_assert(!strcmp(pn->netdev_name, "p0"));
+    ovs_assert(pn->port_node_source == PORT_NODE_SOURCE_SNAPSHOT);
+
+    pn = port_table_lookup_pf_mac_vf(
+        port_table,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42),
+        1);
+    ovs_assert(pn);
+    ovs_assert(pn->netdev_ifindex == 1001);
+    ovs_assert(!strcmp(pn->netdev_name, "pf0vf1"));
+    ovs_assert(
+        eth_addr_equals(pn->mac,
+                        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,01)));
+    ovs_assert(pn == port_table_lookup_ifindex(port_table, 1001));
+    ovs_assert(!port_node_rename_expected(pn));
+    ovs_assert(!port_table_lookup_ifindex(port_table, 20));
+
+    /* ports confirmed by a dump are kept and take on the ifindex it
+     * reports, the rest is swept. */
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 11, "p0", 0,
+        UINT16_MAX, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PHYSICAL,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,00),
+        PORT_NODE_SOURCE_DUMP);
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 100, "p0hpf", UINT32_MAX,
+        0, UINT16_MAX, DEVLINK_PORT_FLAVOUR_PCI_PF,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42),
+        PORT_NODE_SOURCE_DUMP);
+    port_table_update_entry(
+        port_table, "pci", "0000:03:00.0", 2000, "pf0vf0", UINT32_MAX,
+        0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+        (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+        PORT_NODE_SOURCE_DUMP);
+    port_table_sweep_snapshot(port_table);
+
+    pn = port_table_lookup_ifindex(port_table, 2000);
+    ovs_assert(pn);
+    ovs_assert(pn->port_node_source == PORT_NODE_SOURCE_DUMP);
+    ovs_assert(pn == port_table_lookup_pf_mac_vf(
+                         port_table,
+                         (struct eth_addr) ETH_ADDR_C(00,53,00,00,00,42), 0));
+    ovs_assert(cmap_count(&port_table->mac_vf_table) == 1);
+    ovs_assert(!port_table_lookup_ifindex(port_table, 1000));
+    ovs_assert(!port_table_lookup_ifindex(port_table, 1001));
+    ovs_assert(port_table_lookup_ifindex(port_table, 100));
+    pn = port_table_lookup_ifindex(port_table, 11);
+    ovs_assert(pn && !strcmp(pn->netdev_name, "p0"));
+    ovs_assert(!port_table_lookup_ifindex(port_table, 10));
+
+    unlink(file_name);
+    _destroy_store();
+}
+
+static void
+test_port_node_fill_iface_options(struct ovs_cmdl_context *ctx OVS_UNUSED)
+{
+    struct smap iface_options, iface_options_again;
+    struct port_node *pn;
+
+    _init_store();
+
+    pn = port_table_update_entry(
+            port_table, "pci", "0000:03:00.0", 1000, "pf0vf0", UINT32_MAX,
+            0, 0, DEVLINK_PORT_FLAVOUR_PCI_VF,
+            (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+            PORT_NODE_SOURCE_DUMP);
+    ovs_assert(pn);
+
+    smap_init(&iface_options);
+    port_node_fill_iface_options(pn, &iface_options);
+    ovs_assert(smap_count(&iface_options) == 3);
+    ovs_assert(!strcmp(smap_get(&iface_options, OPT_PF_MAC),
+                       "00:53:00:00:00:42"));
+    ovs_assert(!strcmp(smap_get(&iface_options, OPT_VF_NUM), "0"));
+    ovs_assert(!strcmp(smap_get(&iface_options, OPT_IFINDEX), "1000"));
+
+    /* An unchanged representor must produce identical options. */
+    smap_init(&iface_options_again);
+    port_node_fill_iface_options(pn, &iface_options_again);
+    ovs_assert(smap_equal(&iface_options, &iface_options_again));
+
+    smap_destroy(&iface_options_again);
+    smap_destroy(&iface_options);
+    _destroy_store();
+}
+
+/* Populates the port table with one PF and 'n_ports' VFs, and reports the
+ * memory used per port and the time spent on updates and lookups.
+ *
+ *     ovstest test-vif-plug-representor benchmark [N_PORTS]
+ */
+static void
+benchmark_port_table(struct ovs_cmdl_context *ctx)
+{
+    const struct eth_addr pf_mac = ETH_ADDR_C(00,53,00,00,00,42);
+    unsigned int n_ports = 10000;
+    size_t name_bytes = 0;
+    long long int start;
+    unsigned int i;
+
+    if (ctx->argc > 1) {
+        n_ports = MIN(strtoul(ctx->argv[1], NULL, 10), UINT16_MAX);
+    }
+
+    _init_store();
+
+    start = time_msec();
+    for (i = 0; i < n_ports; i++) {
+        char *name = xasprintf("pf0vf%u", i);
+
+        port_table_update_entry(
+                port_table, "pci", "0000:03:00.0", 1000 + i, name,
+                UINT32_MAX, 0, i, DEVLINK_PORT_FLAVOUR_PCI_VF,
+                (struct eth_addr) ETH_ADDR_C(00,53,00,00,10,00),
+                PORT_NODE_SOURCE_DUMP);
+        name_bytes += strlen(name) + 1;
+        free(name);
+    }
+    printf("insert:     %u ports in %lld ms\n", n_ports, time_msec() - start);
+
+    start = time_msec();
+    for (int round = 0; round < 10; round++) {
+        for (i = 0; i < n_ports; i++) {
+            ovs_assert(port_table_lookup_pf_mac_vf(port_table, pf_mac, i));
+        }
+    }
+    printf("lookup:     %u PF MAC+VF lookups in %lld ms\n",
+           10 * n_ports, time_msec() - start);
+
+    start = time_msec();
+    for (int round = 0; round < 10; round++) {
+        for (i = 0; i < n_ports; i++) {
+            ovs_assert(port_table_lookup_ifindex(port_table, 1000 + i));
+        }
+    }
+    printf("lookup:     %u ifindex lookups in %lld ms\n",
+           10 * n_ports, time_msec() - start);
+
+    printf("record:     struct port_node %"PRIuSIZE" bytes, "
+           "struct phy_node %"PRIuSIZE" bytes, "
+           "struct function_node %"PRIuSIZE" bytes\n",
+           sizeof(struct port_node), sizeof(struct phy_node),
+           sizeof(struct function_node));
+    printf("memory:     %"PRIuSIZE" bytes per function port "
+           "(record %"PRIuSIZE", netdev name %"PRIuSIZE")\n",
+           sizeof(struct function_node) + name_bytes / MAX(n_ports, 1),
+           sizeof(struct function_node), name_bytes / MAX(n_ports, 1));
+
+    _destroy_store();
+}
+
 static void
 test_vif_plug_representor_main(int argc, char **argv) {
     set_program_name(*argv);
@@ -1137,8 +7283,40 @@ test_vif_plug_representor_main(int argc, char **argv) {
          test_port_table_delete_devlink_port, OVS_RO},
         {"store-devlink-port-update-compat", NULL, 0, 0,
          test_port_table_update_devlink_port_compat, OVS_RO},
+        {"store-devlink-port-update-compat-cache", NULL, 0, 0,
+         test_port_table_update_devlink_port_compat_cache, OVS_RO},
         {"store-rename-expected", NULL, 0, 0,
          test_port_node_rename_expected, OVS_RO},
+        {"store-rename-wait", NULL, 0, 0,
+         test_port_table_rename_wait, OVS_RO},
+        {"store-rename-buffer", NULL, 0, 0,
+         test_port_table_rename_buffer, OVS_RO},
+        {"rtnl-monitor-cb", NULL, 0, 0, test_rtnl_monitor_cb, OVS_RO},
+        {"monitor-thread", NULL, 0, 0, test_monitor_thread, OVS_RO},
+        {"monitor-filter", NULL, 0, 0, test_monitor_filter, OVS_RO},
+        {"store-pending", NULL, 0, 0, test_port_table_pending, OVS_RO},
+        {"store-pf-mac-change", NULL, 0, 0,
+         test_port_table_pf_mac_change, OVS_RO},
+        {"store-lockless-lookup", NULL, 0, 0,
+         test_port_table_lockless_lookup, OVS_RO},
+        {"store-function-mac", NULL, 0, 0, test_port_table_function_mac,
+         OVS_RO},
+        {"store-set-function-mac", NULL, 0, 0,
+         test_port_table_set_function_mac, OVS_RO},
+        {"store-sf", NULL, 0, 0, test_port_table_sf, OVS_RO},
+        {"store-sf-provision", NULL, 0, 0, test_port_table_provision_sf,
+         OVS_RO},
+        {"store-sf-pool", NULL, 0, 0, test_port_table_sf_pool, OVS_RO},
+        {"store-resync", NULL, 0, 0, test_port_table_resync, OVS_RO},
+        {"store-dump-ready", NULL, 0, 0, test_port_table_dump_ready, OVS_RO},
+        {"store-rate", NULL, 0, 0, test_port_node_set_rate, OVS_RO},
+        {"devlink-params", NULL, 0, 0, test_devlink_params, OVS_RO},
+        {"store-bdf", NULL, 0, 0, test_port_table_bdf, OVS_RO},
+        {"run-budget", NULL, 0, 0, test_run_budget, OVS_RO},
+        {"store-iface-options", NULL, 0, 0,
+         test_port_node_fill_iface_options, OVS_RO},
+        {"store-snapshot", NULL, 0, 0, test_port_snapshot, OVS_RO},
+        {"benchmark", NULL, 0, 1, benchmark_port_table, OVS_RO},
         {NULL, NULL, 0, 0, NULL, OVS_RO},
     };
     struct ovs_cmdl_context ctx;
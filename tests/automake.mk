@@ -76,9 +76,11 @@ tests_ovstest_LDADD = \
         lib/netlink-devlink.$(OBJEXT)
 
 if HAVE_UDEV
+if !ENABLE_RTNETLINK_RENAME_TRACKING
 tests_ovstest_LDADD += \
 	-ludev
 endif
+endif
 
 tests_ovstest_CPPFLAGS = $(AM_CPPFLAGS)
 tests_ovstest_CPPFLAGS += \
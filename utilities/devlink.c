@@ -116,13 +116,55 @@ print_info(struct dl_info *info_entry) {
     print_version("stored", &info_entry->version_stored);
 }
 
+static void
+print_rate(struct dl_rate *rate_entry) {
+    VLOG_INFO("bus_name: '%s'", rate_entry->bus_name);
+    VLOG_INFO("dev_name: '%s'", rate_entry->dev_name);
+    VLOG_INFO("type: %s",
+        rate_entry->type == DEVLINK_RATE_TYPE_LEAF ? "LEAF" :
+        rate_entry->type == DEVLINK_RATE_TYPE_NODE ? "NODE" :
+        "unknown");
+    VLOG_INFO("port_index: %"PRIu32, rate_entry->port_index);
+    VLOG_INFO("node_name: '%s'", rate_entry->node_name);
+    VLOG_INFO("tx_share: %"PRIu64, rate_entry->tx_share);
+    VLOG_INFO("tx_max: %"PRIu64, rate_entry->tx_max);
+    VLOG_INFO("parent_node_name: '%s'", rate_entry->parent_node_name);
+}
+
+static void
+print_param(struct dl_param *param_entry) {
+    VLOG_INFO("bus_name: '%s'", param_entry->bus_name);
+    VLOG_INFO("dev_name: '%s'", param_entry->dev_name);
+    VLOG_INFO("name: '%s'", param_entry->name);
+    VLOG_INFO("generic: %s", param_entry->generic ? "true" : "false");
+    VLOG_INFO("type: %"PRIu8, param_entry->type);
+    for (size_t i = 0; i < param_entry->n_values; i++) {
+        const struct dl_param_value *value = &param_entry->values[i];
+
+        VLOG_INFO("  cmode: %s",
+            value->cmode == DEVLINK_PARAM_CMODE_RUNTIME ? "runtime" :
+            value->cmode == DEVLINK_PARAM_CMODE_DRIVERINIT ? "driverinit" :
+            value->cmode == DEVLINK_PARAM_CMODE_PERMANENT ? "permanent" :
+            "unknown");
+        if (param_entry->type == DL_PARAM_TYPE_STRING) {
+            VLOG_INFO("  value: '%s'", value->string);
+        } else {
+            VLOG_INFO("  value: %"PRIu64, value->data);
+        }
+    }
+}
+
 static void
 dump(void)
 {
     struct nl_dl_dump_state *port_dump;
     struct nl_dl_dump_state *info_dump;
+    struct nl_dl_dump_state *rate_dump;
+    struct nl_dl_dump_state *param_dump;
     struct dl_port port_entry;
     struct dl_info info_entry;
+    struct dl_rate rate_entry;
+    struct dl_param param_entry;
     int error;
 
     printf("port dump\n");
@@ -149,6 +191,30 @@ dump(void)
     }
     nl_dl_dump_finish(info_dump);
     nl_dl_dump_destroy(info_dump);
+
+    printf("rate dump\n");
+    rate_dump = nl_dl_dump_init();
+    if ((error = nl_dl_dump_init_error(rate_dump))) {
+        ovs_fatal(error, "error");
+    }
+    nl_dl_dump_start(DEVLINK_CMD_RATE_GET, rate_dump);
+    while (nl_dl_rate_dump_next(rate_dump, &rate_entry)) {
+        print_rate(&rate_entry);
+    }
+    nl_dl_dump_finish(rate_dump);
+    nl_dl_dump_destroy(rate_dump);
+
+    printf("param dump\n");
+    param_dump = nl_dl_dump_init();
+    if ((error = nl_dl_dump_init_error(param_dump))) {
+        ovs_fatal(error, "error");
+    }
+    nl_dl_dump_start(DEVLINK_CMD_PARAM_GET, param_dump);
+    while (nl_dl_param_dump_next(param_dump, &param_entry)) {
+        print_param(&param_entry);
+    }
+    nl_dl_dump_finish(param_dump);
+    nl_dl_dump_destroy(param_dump);
 }
 
 static void